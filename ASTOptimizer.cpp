@@ -0,0 +1,396 @@
+#include "ASTOptimizer.h"
+
+namespace zhRegex {
+    //构造函数
+    ASTOptimizer::ASTOptimizer(RegexAST &ast) : ast(ast) {}
+
+    //从root可达的节点,子节点在父节点之前
+    std::vector<int> ASTOptimizer::postOrder() const {
+        std::vector<int> order;
+        std::vector<std::pair<int, bool>> nodeStack;
+        nodeStack.emplace_back(ast.root, false);
+        while (!nodeStack.empty()) {
+            auto [node, expanded] = nodeStack.back();
+            nodeStack.pop_back();
+            if (expanded) {
+                order.emplace_back(node);
+                continue;
+            }
+            nodeStack.emplace_back(node, true);
+            const std::vector<int> &children = ast[node].children;
+            for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                nodeStack.emplace_back(*it, false);
+            }
+        }
+        return order;
+    }
+
+    //子树的结构哈希,字符集的哈希与元素顺序无关
+    size_t ASTOptimizer::hashOf(int root) const {
+        auto mix = [](size_t seed, size_t value) {
+            return seed ^ (value + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+        };
+        std::vector<std::pair<int, bool>> nodeStack;
+        //已算出的子树哈希,子节点按顺序排在栈顶
+        std::vector<size_t> values;
+        nodeStack.emplace_back(root, false);
+        while (!nodeStack.empty()) {
+            auto [node, expanded] = nodeStack.back();
+            nodeStack.pop_back();
+            const ASTNode &astNode = ast[node];
+            if (!expanded) {
+                nodeStack.emplace_back(node, true);
+                for (auto it = astNode.children.rbegin(); it != astNode.children.rend(); ++it) {
+                    nodeStack.emplace_back(*it, false);
+                }
+                continue;
+            }
+            size_t hash = mix(static_cast<size_t>(astNode.type), (unsigned char) astNode.value);
+            hash = mix(hash, (size_t) astNode.min);
+            hash = mix(hash, (size_t) astNode.max);
+            if (astNode.charSet != nullptr) {
+                hash = mix(hash, astNode.charSet->hash());
+            }
+            size_t childCount = astNode.children.size();
+            for (size_t i = values.size() - childCount; i < values.size(); i++) {
+                hash = mix(hash, values[i]);
+            }
+            values.resize(values.size() - childCount);
+            values.emplace_back(hash);
+        }
+        return values.back();
+    }
+
+    //两棵子树结构是否相同
+    bool ASTOptimizer::equal(int node1, int node2) const {
+        std::vector<std::pair<int, int>> nodeStack;
+        nodeStack.emplace_back(node1, node2);
+        while (!nodeStack.empty()) {
+            auto [a, b] = nodeStack.back();
+            nodeStack.pop_back();
+            if (a == b)
+                continue;
+            const ASTNode &x = ast[a];
+            const ASTNode &y = ast[b];
+            if (x.type != y.type || x.value != y.value || x.min != y.min || x.max != y.max ||
+                x.children.size() != y.children.size())
+                return false;
+            if ((x.charSet == nullptr) != (y.charSet == nullptr))
+                return false;
+            if (x.charSet != nullptr && x.charSet != y.charSet && *x.charSet != *y.charSet)
+                return false;
+            for (size_t i = 0; i < x.children.size(); i++) {
+                nodeStack.emplace_back(x.children[i], y.children[i]);
+            }
+        }
+        return true;
+    }
+
+    //用other的内容替换node
+    void ASTOptimizer::replace(int node, int other) {
+        ASTNode copy = ast[other];
+        ast[node] = std::move(copy);
+    }
+
+    //将节点看作一个序列(concat的子节点,否则为其自身)
+    std::vector<int> ASTOptimizer::asSequence(int node) const {
+        if (ast[node].type == ASTNodeType::concat)
+            return ast[node].children;
+        if (ast[node].type == ASTNodeType::empty)
+            return {};
+        return {node};
+    }
+
+    //由序列生成节点
+    int ASTOptimizer::fromSequence(std::vector<int> sequence) {
+        if (sequence.empty())
+            return ast.addNode(ASTNodeType::empty);
+        if (sequence.size() == 1)
+            return sequence[0];
+        int node = ast.addNode(ASTNodeType::concat);
+        ast[node].children = std::move(sequence);
+        return node;
+    }
+
+    //新增一个字符集节点,只有一个字符时退化为singleChar
+    int ASTOptimizer::newCharCollection(const CharSet &charSet) {
+        if (charSet.count() == 1) {
+            int node = ast.addNode(ASTNodeType::singleChar);
+            charSet.forEach([&](char c) { ast[node].value = c; });
+            return node;
+        }
+        int node = ast.addNode(ASTNodeType::charCollection);
+        ast[node].charSet = CharSet::shared(charSet);
+        return node;
+    }
+
+    //去掉括号、空串和单个子节点的concat/alternate,并展开嵌套的concat/alternate
+    void ASTOptimizer::removeEmptyGroups() {
+        for (int node: postOrder()) {
+            ASTNode &astNode = ast[node];
+            switch (astNode.type) {
+            case ASTNodeType::group:
+                //括号不影响匹配结果,()即为空串
+                replace(node, astNode.children[0]);
+                break;
+            case ASTNodeType::repeat:
+                if (ast[astNode.children[0]].type == ASTNodeType::empty) {
+                    astNode.type = ASTNodeType::empty;
+                    astNode.children.clear();
+                } else if (astNode.min == 1 && astNode.max == 1) {
+                    replace(node, astNode.children[0]);
+                }
+                break;
+            case ASTNodeType::concat:
+            case ASTNodeType::alternate: {
+                std::vector<int> children;
+                for (int child: astNode.children) {
+                    const ASTNode &childNode = ast[child];
+                    if (astNode.type == ASTNodeType::concat && childNode.type == ASTNodeType::empty)
+                        continue;
+                    if (childNode.type == astNode.type) {
+                        children.insert(children.end(), childNode.children.begin(), childNode.children.end());
+                    } else {
+                        children.emplace_back(child);
+                    }
+                }
+                if (children.empty()) {
+                    astNode.type = ASTNodeType::empty;
+                    astNode.children.clear();
+                } else if (children.size() == 1) {
+                    replace(node, children[0]);
+                } else {
+                    astNode.children = std::move(children);
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    //合并嵌套的闭包((x)*)*,以及相邻的相同闭包x*x*
+    void ASTOptimizer::collapseClosures() {
+        //*,+,?三种闭包
+        auto simple = [](const ASTNode &node) {
+            return node.type == ASTNodeType::repeat && (node.min == 0 || node.min == 1) &&
+                   (node.max == 1 || node.max == -1);
+        };
+        for (int node: postOrder()) {
+            ASTNode &astNode = ast[node];
+            if (astNode.type == ASTNodeType::repeat) {
+                const ASTNode &child = ast[astNode.children[0]];
+                if (simple(astNode) && simple(child)) {
+                    //两层闭包都要求至少一次时才至少一次,任意一层可无限时即可无限
+                    astNode.min = astNode.min == 1 && child.min == 1 ? 1 : 0;
+                    astNode.max = astNode.max == -1 || child.max == -1 ? -1 : 1;
+                    std::vector<int> children = child.children;
+                    astNode.children = std::move(children);
+                }
+            } else if (astNode.type == ASTNodeType::concat) {
+                //x{a,}x{b,}等价于x{a+b,}
+                std::vector<int> children;
+                for (int child: astNode.children) {
+                    if (!children.empty()) {
+                        ASTNode &prev = ast[children.back()];
+                        const ASTNode &current = ast[child];
+                        if (prev.type == ASTNodeType::repeat && current.type == ASTNodeType::repeat &&
+                            prev.max == -1 && current.max == -1 && equal(prev.children[0], current.children[0])) {
+                            prev.min += current.min;
+                            continue;
+                        }
+                    }
+                    children.emplace_back(child);
+                }
+                if (children.size() == 1) {
+                    replace(node, children[0]);
+                } else {
+                    astNode.children = std::move(children);
+                }
+            }
+        }
+    }
+
+    //将单字符/字符集的分支合并为一个字符集,并去掉重复的分支
+    void ASTOptimizer::mergeCharAlternation() {
+        for (int node: postOrder()) {
+            if (ast[node].type != ASTNodeType::alternate)
+                continue;
+            std::vector<int> branches = ast[node].children;
+            CharSet merged;
+            int charBranches = 0;
+            int firstCharBranch = -1;
+            std::vector<int> children;
+            hashMap<size_t, std::vector<int>> seen;
+            for (int branch: branches) {
+                const ASTNode &branchNode = ast[branch];
+                if (branchNode.type == ASTNodeType::singleChar) {
+                    merged.add(branchNode.value);
+                } else if (branchNode.type == ASTNodeType::charCollection) {
+                    merged |= *branchNode.charSet;
+                } else if (branchNode.type == ASTNodeType::anyChar) {
+                    merged = ~CharSet();
+                } else {
+                    //其余分支去重
+                    std::vector<int> &candidates = seen[hashOf(branch)];
+                    bool duplicate = false;
+                    for (int candidate: candidates) {
+                        if (equal(candidate, branch)) {
+                            duplicate = true;
+                            break;
+                        }
+                    }
+                    if (!duplicate) {
+                        candidates.emplace_back(branch);
+                        children.emplace_back(branch);
+                    }
+                    continue;
+                }
+                if (charBranches++ == 0) {
+                    firstCharBranch = (int) children.size();
+                    children.emplace_back(branch);
+                }
+            }
+            if (charBranches > 1) {
+                children[firstCharBranch] = newCharCollection(merged);
+            }
+            if (children.size() == 1) {
+                replace(node, children[0]);
+            } else {
+                ast[node].children = std::move(children);
+            }
+        }
+    }
+
+    //对一个alternate节点提取公共前缀,新生成的alternate节点放入work
+    void ASTOptimizer::factorAlternate(int node, std::vector<int> &work) {
+        std::vector<int> branches = ast[node].children;
+        std::vector<std::vector<int>> sequences;
+        for (int branch: branches) {
+            sequences.emplace_back(asSequence(branch));
+        }
+        //按第一个元素分组,保持首次出现的顺序
+        std::vector<std::vector<int>> groups;
+        hashMap<size_t, std::vector<int>> groupByHash;
+        for (int i = 0; i < (int) sequences.size(); i++) {
+            if (sequences[i].empty()) {
+                groups.push_back({i});
+                continue;
+            }
+            std::vector<int> &candidates = groupByHash[hashOf(sequences[i][0])];
+            bool found = false;
+            for (int group: candidates) {
+                if (equal(sequences[groups[group][0]][0], sequences[i][0])) {
+                    groups[group].emplace_back(i);
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                candidates.emplace_back((int) groups.size());
+                groups.push_back({i});
+            }
+        }
+        if (groups.size() == branches.size())
+            return;
+        std::vector<int> children;
+        for (auto &group: groups) {
+            if (group.size() == 1) {
+                children.emplace_back(branches[group[0]]);
+                continue;
+            }
+            //组内最长公共前缀
+            const std::vector<int> &first = sequences[group[0]];
+            size_t prefix = 1;
+            while (true) {
+                bool same = true;
+                for (int i: group) {
+                    if (sequences[i].size() <= prefix || !equal(sequences[i][prefix], first[prefix])) {
+                        same = false;
+                        break;
+                    }
+                }
+                if (!same)
+                    break;
+                prefix++;
+            }
+            //剩余部分,空串单独记录
+            std::vector<int> rests;
+            bool hasEmpty = false;
+            for (int i: group) {
+                if (sequences[i].size() == prefix) {
+                    hasEmpty = true;
+                    continue;
+                }
+                rests.emplace_back(fromSequence(std::vector<int>(sequences[i].begin() + prefix, sequences[i].end())));
+            }
+            std::vector<int> sequence(first.begin(), first.begin() + prefix);
+            if (!rests.empty()) {
+                int rest = rests[0];
+                if (rests.size() > 1) {
+                    rest = ast.addNode(ASTNodeType::alternate);
+                    ast[rest].children = std::move(rests);
+                    work.emplace_back(rest);
+                }
+                if (hasEmpty) {
+                    //ab|abc变为ab(c)?
+                    int optional = ast.addNode(ASTNodeType::repeat);
+                    ast[optional].min = 0;
+                    ast[optional].max = 1;
+                    ast[optional].children.emplace_back(rest);
+                    rest = optional;
+                }
+                sequence.emplace_back(rest);
+            }
+            children.emplace_back(fromSequence(std::move(sequence)));
+        }
+        if (children.size() == 1) {
+            replace(node, children[0]);
+        } else {
+            ast[node].children = std::move(children);
+        }
+    }
+
+    //提取alternate各分支的公共前缀(trie化),如abc|abd变为ab(c|d)
+    void ASTOptimizer::factorPrefixes() {
+        std::vector<int> work;
+        for (int node: postOrder()) {
+            if (ast[node].type == ASTNodeType::alternate)
+                work.emplace_back(node);
+        }
+        while (!work.empty()) {
+            int node = work.back();
+            work.pop_back();
+            if (ast[node].type == ASTNodeType::alternate)
+                factorAlternate(node, work);
+        }
+    }
+
+    //从root可达的节点个数
+    int ASTOptimizer::nodeCount() const {
+        return (int) postOrder().size();
+    }
+
+    //依次执行全部化简,返回每一趟的报告
+    std::vector<ASTPassReport> ASTOptimizer::optimize(
+            RegexAST &ast, const std::function<void(ASTPassReport &)> &afterPass) {
+        ASTOptimizer optimizer(ast);
+        std::vector<ASTPassReport> reports;
+        auto run = [&](const char *name, void (ASTOptimizer::*pass)()) {
+            int before = optimizer.nodeCount();
+            (optimizer.*pass)();
+            reports.push_back({name, before, optimizer.nodeCount()});
+            if (afterPass)
+                afterPass(reports.back());
+        };
+        run("removeEmptyGroups", &ASTOptimizer::removeEmptyGroups);
+        run("collapseClosures", &ASTOptimizer::collapseClosures);
+        run("mergeCharAlternation", &ASTOptimizer::mergeCharAlternation);
+        run("factorPrefixes", &ASTOptimizer::factorPrefixes);
+        //提取前缀后会产生新的单字符分支与嵌套的concat
+        run("mergeCharAlternation", &ASTOptimizer::mergeCharAlternation);
+        run("removeEmptyGroups", &ASTOptimizer::removeEmptyGroups);
+        return reports;
+    }
+}  // namespace zhRegex
@@ -0,0 +1,66 @@
+#ifndef _ZH_AST_OPTIMIZER_H_
+#define _ZH_AST_OPTIMIZER_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "RegexAST.h"
+
+namespace zhRegex {
+    //一趟化简前后的AST节点个数
+    struct ASTPassReport {
+        std::string name;
+        int nodesBefore;
+        int nodesAfter;
+        //由调用者在afterPass中按需填写
+        int nfaNodes = 0;
+        int dfaStates = 0;
+    };
+
+    //在构造NFA之前对AST做等价化简,减少epslion节点与DFA状态
+    //所有遍历均使用显式栈,与Parser一样不依赖递归
+    class ASTOptimizer {
+    private:
+        RegexAST &ast;
+
+        //从root可达的节点,子节点在父节点之前
+        std::vector<int> postOrder() const;
+        //子树的结构哈希
+        size_t hashOf(int node) const;
+        //两棵子树结构是否相同
+        bool equal(int node1, int node2) const;
+        //用other的内容替换node
+        void replace(int node, int other);
+        //将节点看作一个序列(concat的子节点,否则为其自身)
+        std::vector<int> asSequence(int node) const;
+        //由序列生成节点
+        int fromSequence(std::vector<int> sequence);
+        //新增一个字符集节点
+        int newCharCollection(const CharSet &charSet);
+
+        //对一个alternate节点提取公共前缀,新生成的alternate节点放入work
+        void factorAlternate(int node, std::vector<int> &work);
+
+    public:
+        explicit ASTOptimizer(RegexAST &ast);
+
+        //去掉括号、空串和单个子节点的concat/alternate,并展开嵌套的concat/alternate
+        void removeEmptyGroups();
+        //合并嵌套的闭包((x)*)*,以及相邻的相同闭包x*x*
+        void collapseClosures();
+        //将单字符/字符集的分支合并为一个字符集,并去掉重复的分支
+        void mergeCharAlternation();
+        //提取alternate各分支的公共前缀(trie化),如abc|abd变为ab(c|d)
+        void factorPrefixes();
+
+        //从root可达的节点个数
+        int nodeCount() const;
+
+        //依次执行全部化简,返回每一趟的报告,每一趟结束后调用afterPass
+        static std::vector<ASTPassReport> optimize(
+                RegexAST &ast, const std::function<void(ASTPassReport &)> &afterPass = nullptr);
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_AST_OPTIMIZER_H_
@@ -0,0 +1,72 @@
+#ifndef _ZH_BYTE_SCAN_H_
+#define _ZH_BYTE_SCAN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define ZH_REGEX_SSE2 1
+#endif
+
+namespace zhRegex {
+    //查找[p,end)中第一个属于bytes(至多3个)的字节,返回其位置,不存在则返回end
+    //即memchr2/memchr3,用于加速态跳过自环
+    inline const char *findAnyOf(const char *p, const char *end, const uint8_t *bytes, int count) {
+        if (count == 0)
+            return end;
+        if (count == 1) {
+            const void *r = std::memchr(p, bytes[0], end - p);
+            return r == nullptr ? end : static_cast<const char *>(r);
+        }
+        uint8_t b0 = bytes[0], b1 = bytes[1], b2 = count > 2 ? bytes[2] : bytes[1];
+#ifdef ZH_REGEX_SSE2
+        __m128i v0 = _mm_set1_epi8((char) b0);
+        __m128i v1 = _mm_set1_epi8((char) b1);
+        __m128i v2 = _mm_set1_epi8((char) b2);
+        while (end - p >= 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, v0), _mm_cmpeq_epi8(chunk, v1)),
+                                      _mm_cmpeq_epi8(chunk, v2));
+            int mask = _mm_movemask_epi8(eq);
+            if (mask != 0)
+                return p + __builtin_ctz((unsigned) mask);
+            p += 16;
+        }
+#endif
+        for (; p < end; ++p) {
+            auto c = (uint8_t) *p;
+            if (c == b0 || c == b1 || c == b2)
+                return p;
+        }
+        return end;
+    }
+
+    //查找[p,end)中第一个不在[lo,hi]区间内的字节,返回其位置,不存在则返回end
+    //用于[0-9]+之类自环为连续区间的加速态
+    inline const char *findNotInRange(const char *p, const char *end, uint8_t lo, uint8_t hi) {
+        auto width = (uint8_t) (hi - lo);
+#ifdef ZH_REGEX_SSE2
+        __m128i vlo = _mm_set1_epi8((char) lo);
+        __m128i vwidth = _mm_set1_epi8((char) width);
+        __m128i zero = _mm_setzero_si128();
+        while (end - p >= 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            //c - lo后做饱和减法,结果为0说明c处在区间内
+            __m128i over = _mm_subs_epu8(_mm_sub_epi8(chunk, vlo), vwidth);
+            int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(over, zero)) ^ 0xFFFF;
+            if (mask != 0)
+                return p + __builtin_ctz((unsigned) mask);
+            p += 16;
+        }
+#endif
+        for (; p < end; ++p) {
+            if ((uint8_t) ((uint8_t) *p - lo) > width)
+                return p;
+        }
+        return end;
+    }
+}  // namespace zhRegex
+
+#endif  // !_ZH_BYTE_SCAN_H_
@@ -0,0 +1,141 @@
+#include "CharSet.h"
+
+#include <functional>
+#include <vector>
+
+namespace zhRegex {
+    namespace {
+        //由字节谓词在编译期生成位图
+        template <typename Predicate>
+        constexpr ByteBitmap bitmapOf(Predicate predicate) {
+            ByteBitmap bits{};
+            for (int b = 0; b < 256; b++) {
+                if (predicate(b))
+                    bits[b >> 6] |= uint64_t(1) << (b & 63);
+            }
+            return bits;
+        }
+
+        constexpr ByteBitmap complement(ByteBitmap bits) {
+            for (uint64_t &word : bits)
+                word = ~word;
+            return bits;
+        }
+
+        constexpr bool isUpper(int b) {
+            return 'A' <= b && b <= 'Z';
+        }
+
+        constexpr bool isLower(int b) {
+            return 'a' <= b && b <= 'z';
+        }
+
+        constexpr bool isDigit(int b) {
+            return '0' <= b && b <= '9';
+        }
+
+        constexpr bool isAlpha(int b) {
+            return isUpper(b) || isLower(b);
+        }
+
+        constexpr bool isSpace(int b) {
+            return b == ' ' || ('\t' <= b && b <= '\r');
+        }
+
+        constexpr bool isGraph(int b) {
+            return 0x21 <= b && b <= 0x7E;
+        }
+
+        constexpr bool isHexDigit(int b) {
+            return isDigit(b) || ('a' <= (b | 0x20) && (b | 0x20) <= 'f');
+        }
+
+        //\d,\w,\s的位图,\w只含ASCII字母
+        constexpr ByteBitmap digitBits = bitmapOf(isDigit);
+        constexpr ByteBitmap wordBits = bitmapOf(isAlpha);
+        constexpr ByteBitmap spaceBits = bitmapOf(isSpace);
+
+        constexpr CharSet escapeSets[] = {
+                CharSet(digitBits), CharSet(complement(digitBits)),
+                CharSet(wordBits), CharSet(complement(wordBits)),
+                CharSet(spaceBits), CharSet(complement(spaceBits))};
+
+        struct PosixClass {
+            std::string_view name;
+            CharSet set;
+        };
+
+        constexpr PosixClass posixClasses[] = {
+                {"alnum", CharSet(bitmapOf([](int b) { return isAlpha(b) || isDigit(b); }))},
+                {"alpha", CharSet(bitmapOf(isAlpha))},
+                {"blank", CharSet(bitmapOf([](int b) { return b == ' ' || b == '\t'; }))},
+                {"cntrl", CharSet(bitmapOf([](int b) { return b < 0x20 || b == 0x7F; }))},
+                {"digit", CharSet(digitBits)},
+                {"graph", CharSet(bitmapOf(isGraph))},
+                {"lower", CharSet(bitmapOf(isLower))},
+                {"print", CharSet(bitmapOf([](int b) { return b == ' ' || isGraph(b); }))},
+                {"punct", CharSet(bitmapOf([](int b) { return isGraph(b) && !isAlpha(b) && !isDigit(b); }))},
+                {"space", CharSet(spaceBits)},
+                {"upper", CharSet(bitmapOf(isUpper))},
+                {"xdigit", CharSet(bitmapOf(isHexDigit))}};
+
+        //预定义字符集的共享实例,先为escapeSets再为posixClasses,首次使用时创建
+        const std::vector<std::shared_ptr<const CharSet>> &sharedSets() {
+            static const std::vector<std::shared_ptr<const CharSet>> sets = [] {
+                std::vector<std::shared_ptr<const CharSet>> result;
+                for (const CharSet &set : escapeSets)
+                    result.push_back(std::make_shared<const CharSet>(set));
+                for (const PosixClass &posix : posixClasses)
+                    result.push_back(std::make_shared<const CharSet>(posix.set));
+                return result;
+            }();
+            return sets;
+        }
+    }  // namespace
+
+    size_t CharSet::hash() const {
+        size_t hash = 0;
+        for (uint64_t word : bits)
+            hash = hash * 0x9E3779B97F4A7C15ULL + std::hash<uint64_t>()(word);
+        return hash;
+    }
+
+    //转义字符集\d,\D,\w,\W,\s,\S
+    const CharSet *CharSet::escape(char c) {
+        switch (c) {
+        case 'd':
+            return &escapeSets[0];
+        case 'D':
+            return &escapeSets[1];
+        case 'w':
+            return &escapeSets[2];
+        case 'W':
+            return &escapeSets[3];
+        case 's':
+            return &escapeSets[4];
+        case 'S':
+            return &escapeSets[5];
+        default:
+            return nullptr;
+        }
+    }
+
+    // POSIX字符集[:name:]
+    const CharSet *CharSet::posix(std::string_view name) {
+        for (const PosixClass &posix : posixClasses) {
+            if (posix.name == name)
+                return &posix.set;
+        }
+        return nullptr;
+    }
+
+    //与某个预定义字符集相同时返回其共享实例,比较只需4次整数比较
+    std::shared_ptr<const CharSet> CharSet::shared(const CharSet &set) {
+        const std::vector<std::shared_ptr<const CharSet>> &sets = sharedSets();
+        for (const std::shared_ptr<const CharSet> &predefined : sets) {
+            if (*predefined == set)
+                return predefined;
+        }
+        return std::make_shared<const CharSet>(set);
+    }
+}  // namespace zhRegex
@@ -0,0 +1,137 @@
+#ifndef _ZH_CHAR_SET_H_
+#define _ZH_CHAR_SET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "Look.h"
+
+namespace zhRegex {
+    //字节集合,以256位的位图存放,集合运算即按位运算
+    //转义字符集与POSIX字符集为编译期生成的位图,对应的集合由所有pattern共享
+    class CharSet {
+    private:
+        ByteBitmap bits{};
+
+    public:
+        constexpr CharSet() = default;
+
+        explicit constexpr CharSet(const ByteBitmap &bits) : bits(bits) {}
+
+        //只含字节c的集合
+        static inline CharSet of(char c) {
+            CharSet set;
+            set.add(c);
+            return set;
+        }
+
+        //字节区间[lo, hi]
+        static inline CharSet range(uint8_t lo, uint8_t hi) {
+            CharSet set;
+            set.addRange(lo, hi);
+            return set;
+        }
+
+        inline bool contains(char c) const {
+            return (bits[(uint8_t) c >> 6] >> ((uint8_t) c & 63)) & 1;
+        }
+
+        inline void add(char c) {
+            bits[(uint8_t) c >> 6] |= uint64_t(1) << ((uint8_t) c & 63);
+        }
+
+        inline void addRange(uint8_t lo, uint8_t hi) {
+            for (int b = lo; b <= hi; b++)
+                add((char) b);
+        }
+
+        inline CharSet &operator|=(const CharSet &other) {
+            for (int i = 0; i < 4; i++)
+                bits[i] |= other.bits[i];
+            return *this;
+        }
+
+        inline CharSet &operator&=(const CharSet &other) {
+            for (int i = 0; i < 4; i++)
+                bits[i] &= other.bits[i];
+            return *this;
+        }
+
+        inline CharSet operator~() const {
+            CharSet result;
+            for (int i = 0; i < 4; i++)
+                result.bits[i] = ~bits[i];
+            return result;
+        }
+
+        inline CharSet operator|(const CharSet &other) const {
+            CharSet result = *this;
+            return result |= other;
+        }
+
+        inline CharSet operator&(const CharSet &other) const {
+            CharSet result = *this;
+            return result &= other;
+        }
+
+        inline bool operator==(const CharSet &other) const {
+            return bits == other.bits;
+        }
+
+        inline bool operator!=(const CharSet &other) const {
+            return bits != other.bits;
+        }
+
+        //字节个数
+        inline int count() const {
+            return __builtin_popcountll(bits[0]) + __builtin_popcountll(bits[1]) + __builtin_popcountll(bits[2]) +
+                   __builtin_popcountll(bits[3]);
+        }
+
+        inline bool empty() const {
+            return (bits[0] | bits[1] | bits[2] | bits[3]) == 0;
+        }
+
+        //按字节升序访问每个字节
+        template <typename Visit>
+        void forEach(Visit &&visit) const {
+            for (int i = 0; i < 4; i++) {
+                for (uint64_t word = bits[i]; word != 0; word &= word - 1)
+                    visit((char) (i * 64 + __builtin_ctzll(word)));
+            }
+        }
+
+        //按升序访问每个极大的连续区间[lo, hi]
+        template <typename Visit>
+        void forEachRange(Visit &&visit) const {
+            int b = 0;
+            while (b < 256) {
+                if (!contains((char) b)) {
+                    b++;
+                    continue;
+                }
+                int lo = b;
+                while (b < 256 && contains((char) b))
+                    b++;
+                visit((uint8_t) lo, (uint8_t) (b - 1));
+            }
+        }
+
+        inline const ByteBitmap &bitmap() const {
+            return bits;
+        }
+
+        size_t hash() const;
+
+        //转义字符集\d,\D,\w,\W,\s,\S,c不是这些字符时返回nullptr
+        static const CharSet *escape(char c);
+        // POSIX字符集[:name:]的ASCII部分,name不存在时返回nullptr
+        static const CharSet *posix(std::string_view name);
+        //与set相同的共享集合:与某个预定义字符集相同时返回其共享实例,否则新建
+        static std::shared_ptr<const CharSet> shared(const CharSet &set);
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_CHAR_SET_H_
@@ -0,0 +1,57 @@
+#ifndef _ZH_COMPILE_LIMITS_H_
+#define _ZH_COMPILE_LIMITS_H_
+
+#include <chrono>
+#include <cstddef>
+
+#include "RegexException.h"
+
+namespace zhRegex {
+    //编译时的资源限制,0表示不限制
+    struct CompileLimits {
+        //NFA节点数,Glushkov构造时为展开{n,m}后的AST节点数
+        size_t maxNFANodes = 0;
+        //DFA状态数
+        size_t maxDFAStates = 0;
+        //子集构造期间状态集合与转换表占用的估计字节数
+        size_t maxDFABytes = 0;
+        //整个编译过程的耗时
+        std::chrono::milliseconds maxTime{0};
+    };
+
+    //一次编译的预算,由构造NFA、子集构造与最小化在各自的循环中检查
+    //超出时抛出对应错误码的RegexException
+    class CompileBudget {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        CompileLimits limits;
+        Clock::time_point begin;
+
+    public:
+        explicit CompileBudget(const CompileLimits &limits) : limits(limits), begin(Clock::now()) {}
+
+        inline void checkNFANodes(size_t nodes) const {
+            if (limits.maxNFANodes > 0 && nodes > limits.maxNFANodes)
+                throw RegexException(RegexErrorCode::nfaNodeLimit, limits.maxNFANodes, nodes);
+        }
+
+        inline void checkDFA(size_t states, size_t bytes) const {
+            if (limits.maxDFAStates > 0 && states > limits.maxDFAStates)
+                throw RegexException(RegexErrorCode::dfaStateLimit, limits.maxDFAStates, states);
+            if (limits.maxDFABytes > 0 && bytes > limits.maxDFABytes)
+                throw RegexException(RegexErrorCode::dfaMemoryLimit, limits.maxDFABytes, bytes);
+        }
+
+        inline void checkTime() const {
+            if (limits.maxTime.count() <= 0)
+                return;
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - begin);
+            if (elapsed > limits.maxTime)
+                throw RegexException(RegexErrorCode::timeLimit, (size_t) limits.maxTime.count(),
+                                     (size_t) elapsed.count());
+        }
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_COMPILE_LIMITS_H_
@@ -1,296 +1,1007 @@
 #include "DFA.h"
 
+#include <istream>
+#include <ostream>
+
+#include "SubsetBuilder.h"
+
 namespace zhRegex {
     //构造函数
-    DFA::DFA(const char *pattern, bool getMINDFA) {
-        NFA machine(pattern);
-        *this = machine.NFAToDFA();
-        if (getMINDFA)
-            getMinimizeDFA();
+    DFA::DFA(const char *pattern, bool getMINDFA, NFAConstruction construction, unsigned threads,
+             unsigned flags, const CompileLimits &limits) {
+        std::string_view patternS = pattern;
+        compile(patternS, getMINDFA, construction, threads, flags, limits);
     }
 
-    DFA::DFA(std::string &pattern, bool getMINDFA) {
-        NFA machine(pattern);
-        *this = machine.NFAToDFA();
-        if (getMINDFA)
-            getMinimizeDFA();
+    DFA::DFA(std::string &pattern, bool getMINDFA, NFAConstruction construction, unsigned threads,
+             unsigned flags, const CompileLimits &limits) {
+        std::string_view patternS = pattern;
+        compile(patternS, getMINDFA, construction, threads, flags, limits);
+    }
+
+    DFA::DFA(std::string_view &pattern, bool getMINDFA, NFAConstruction construction, unsigned threads,
+             unsigned flags, const CompileLimits &limits) {
+        compile(pattern, getMINDFA, construction, threads, flags, limits);
     }
 
-    DFA::DFA(std::string_view &pattern, bool getMINDFA) {
-        NFA machine(pattern);
-        *this = machine.NFAToDFA();
+    DFA::DFA(NFA &machine, bool getMINDFA, unsigned threads, const CompileLimits &limits) {
+        ZH_STATS_COMPILE_BEGIN();
+        CompileBudget budget(limits);
+        *this = machine.subsetConstruction(threads, &budget);
         if (getMINDFA)
-            getMinimizeDFA();
+            getMinimizeDFA(&budget);
+        finalize();
+        ZH_STATS_COMPILE_END(RegexStats::patternOf(machine.statsId), "dfa", stateCount());
     }
 
-    DFA::DFA(NFA &machine, bool getMINDFA) {
-        *this = machine.NFAToDFA();
+    DFA::DFA(PositionNFA &machine, bool getMINDFA, unsigned threads, const CompileLimits &limits) {
+        ZH_STATS_COMPILE_BEGIN();
+        CompileBudget budget(limits);
+        *this = machine.subsetConstruction(threads, &budget);
         if (getMINDFA)
-            getMinimizeDFA();
+            getMinimizeDFA(&budget);
+        finalize();
+        ZH_STATS_COMPILE_END(RegexStats::patternOf(machine.statsId), "dfa", stateCount());
     }
 
-    //判断是否存在最终状态
-    bool DFA::isFinalStatus(hashSet<NFANode *> &closureSet) {
-        for (NFANode *nfaNode: closureSet) {
-            if (nfaNode->edgeType == NFAEdgeType::eofEdge) {
-                return true;
-            }
+    //由pattern构造,Glushkov构造没有epslion边,子集构造时无需求闭包
+    //构造NFA、子集构造与最小化共用同一份预算
+    void DFA::compile(std::string_view &pattern, bool getMINDFA, NFAConstruction construction, unsigned threads,
+                      unsigned flags, const CompileLimits &limits) {
+        ZH_STATS_COMPILE_BEGIN();
+        CompileBudget budget(limits);
+        Parser parser(pattern, flags);
+        RegexAST ast = parser.parse();
+        ASTOptimizer::optimize(ast);
+        if (construction == NFAConstruction::glushkov) {
+            PositionNFA machine(ast, &budget);
+            *this = machine.subsetConstruction(threads, &budget);
+        } else {
+            NFA machine(ast, &budget);
+            *this = machine.subsetConstruction(threads, &budget);
         }
-        return false;
+        if (getMINDFA)
+            getMinimizeDFA(&budget);
+        finalize();
+        ZH_STATS_COMPILE_END(pattern, "dfa", stateCount());
     }
 
-    //查看某个状态集合是否在现行已划分的集合中
-    bool DFA::isStatusSetInExistSet(
-            std::vector<hashSet<int>> &existStatusSet, hashSet<int> &nextStatusSet) {
-        for (auto &set: existStatusSet) {
-            bool flag = true;
-            for (int status: nextStatusSet) {
-                if (set.find(status) == set.end()) {
-                    flag = false;
-                    break;
+    //获取最小DFA(Hopcroft划分细化)
+    //缺失的转移视为到达一个单独成块的汇点,因此不会与真实状态合并,结果与逐轮按签名细分得到的最粗划分相同
+    //待处理的分割者为(块,字节类),只有在分割者中有后继的状态所在的块才会被细分,细分后只把较小的一半加入队列,
+    //总耗时为O(n·k·log n),链状DFA也不再需要n轮;块最后按其第一个状态的下标顺序编号,结果是确定的
+    void DFA::getMinimizeDFA(const CompileBudget *budget, std::vector<int> *tags) {
+        int len = (int) table.size();
+        if (len == 0)
+            return;
+        //借助紧凑转换表得到字节等价类,只需按类细分
+        TransitionTable dense(table);
+        int classCount = dense.classes();
+        //状态len为汇点
+        int total = len + 1;
+        //preds[predStart[cls * total + t], predStart[cls * total + t + 1])为经过cls到达t的状态
+        std::vector<int> predStart((size_t) classCount * total + 1, 0);
+        std::vector<int> preds((size_t) classCount * total);
+        auto target = [&](int status, int cls) {
+            int next = status < len ? dense.nextByClass(status, cls) : -1;
+            return next < 0 ? len : next;
+        };
+        for (int cls = 0; cls < classCount; cls++) {
+            for (int status = 0; status < total; status++)
+                predStart[(size_t) cls * total + target(status, cls) + 1]++;
+        }
+        for (size_t i = 1; i < predStart.size(); i++)
+            predStart[i] += predStart[i - 1];
+        {
+            std::vector<int> fill(predStart.begin(), predStart.end() - 1);
+            for (int cls = 0; cls < classCount; cls++) {
+                for (int status = 0; status < total; status++)
+                    preds[fill[(size_t) cls * total + target(status, cls)]++] = status;
+            }
+        }
+        //块b的状态为elements[blockBegin[b], blockEnd[b]),position为状态在elements中的下标
+        std::vector<int> block(total);
+        std::vector<int> elements(total);
+        std::vector<int> position(total);
+        std::vector<int> blockBegin;
+        std::vector<int> blockEnd;
+        //先按是否为终态划分,含零宽断言时还需区分在哪些字节之前可作为终态,有tags时还需区分标记;汇点单独成块
+        {
+            StateSetArena initial;
+            bool inserted;
+            std::vector<uint32_t> signature;
+            for (int status = 0; status < len; status++) {
+                signature.assign(1, statusMap[status]);
+                if (tags != nullptr)
+                    signature.push_back((uint32_t) (*tags)[status]);
+                if (!lookAccept.empty()) {
+                    for (uint64_t bits : lookAccept[status]) {
+                        signature.push_back((uint32_t) bits);
+                        signature.push_back((uint32_t) (bits >> 32));
+                    }
                 }
+                block[status] = initial.intern(signature, inserted);
             }
-            if (flag) {
-                return true;
+            block[len] = initial.size();
+            std::vector<int> sizes(initial.size() + 1, 0);
+            for (int status = 0; status < total; status++)
+                sizes[block[status]]++;
+            int offset = 0;
+            for (int size : sizes) {
+                blockBegin.push_back(offset);
+                blockEnd.push_back(offset);
+                offset += size;
+            }
+            for (int status = 0; status < total; status++) {
+                position[status] = blockEnd[block[status]]++;
+                elements[position[status]] = status;
             }
         }
-        return false;
+        //初始时除最大的块外全部加入队列:被其余各块区分的状态必然也被最大的块区分
+        std::vector<std::pair<int, int>> splitters;
+        std::vector<bool> queued((size_t) total * classCount, false);
+        auto enqueue = [&](int b, int cls) {
+            queued[(size_t) b * classCount + cls] = true;
+            splitters.emplace_back(b, cls);
+        };
+        {
+            int largest = 0;
+            for (int b = 1; b < (int) blockBegin.size(); b++) {
+                if (blockEnd[b] - blockBegin[b] > blockEnd[largest] - blockBegin[largest])
+                    largest = b;
+            }
+            for (int b = 0; b < (int) blockBegin.size(); b++) {
+                if (b == largest)
+                    continue;
+                for (int cls = 0; cls < classCount; cls++)
+                    enqueue(b, cls);
+            }
+        }
+        //marked[b]为块b中已移到开头的状态数,touched为本次被标记过的块
+        std::vector<int> marked(total, 0);
+        std::vector<int> touched;
+        std::vector<int> predecessors;
+        size_t processed = 0;
+        while (!splitters.empty()) {
+            auto [splitter, cls] = splitters.back();
+            splitters.pop_back();
+            queued[(size_t) splitter * classCount + cls] = false;
+            if (budget != nullptr && ++processed % 1024 == 0)
+                budget->checkTime();
+            //先取出全部前驱,细分可能改变splitter的范围
+            predecessors.clear();
+            for (int i = blockBegin[splitter]; i < blockEnd[splitter]; i++) {
+                size_t key = (size_t) cls * total + elements[i];
+                predecessors.insert(predecessors.end(), preds.begin() + predStart[key],
+                                    preds.begin() + predStart[key + 1]);
+            }
+            //把前驱移到所在块的开头
+            for (int status : predecessors) {
+                int b = block[status];
+                int first = blockBegin[b] + marked[b];
+                if (position[status] < first)
+                    continue;
+                if (marked[b]++ == 0)
+                    touched.push_back(b);
+                int other = elements[first];
+                std::swap(elements[first], elements[position[status]]);
+                position[other] = position[status];
+                position[status] = first;
+            }
+            for (int b : touched) {
+                int count = marked[b];
+                marked[b] = 0;
+                if (count == blockEnd[b] - blockBegin[b])
+                    continue;
+                //已标记的部分成为新块
+                int created = (int) blockBegin.size();
+                blockBegin.push_back(blockBegin[b]);
+                blockEnd.push_back(blockBegin[b] + count);
+                blockBegin[b] += count;
+                for (int i = blockBegin[created]; i < blockEnd[created]; i++)
+                    block[elements[i]] = created;
+                bool smallerIsNew = count <= blockEnd[b] - blockBegin[b];
+                for (int c = 0; c < classCount; c++) {
+                    if (queued[(size_t) b * classCount + c])
+                        enqueue(created, c);
+                    else
+                        enqueue(smallerIsNew ? created : b, c);
+                }
+            }
+            touched.clear();
+        }
+        //按第一个状态的下标顺序重新编号块,汇点不是真实状态
+        std::vector<int> blockId(blockBegin.size(), -1);
+        int blockCount = 0;
+        for (int status = 0; status < len; status++) {
+            int &id = blockId[block[status]];
+            if (id < 0)
+                id = blockCount++;
+        }
+        for (int status = 0; status < len; status++)
+            block[status] = blockId[block[status]];
+        //根据新的划分创建table,每个块选取第一个状态作为代表
+        std::vector<hashMap<char, int>> newTable(blockCount);
+        std::vector<bool> newStatusMap(blockCount, false);
+        std::vector<ByteBitmap> newLookAccept(lookAccept.empty() ? 0 : blockCount);
+        std::vector<int> newTags(tags != nullptr ? blockCount : 0);
+        std::vector<bool> visited(blockCount, false);
+        for (int status = 0; status < len; status++) {
+            int b = block[status];
+            if (visited[b])
+                continue;
+            visited[b] = true;
+            newStatusMap[b] = statusMap[status];
+            if (!lookAccept.empty())
+                newLookAccept[b] = lookAccept[status];
+            if (tags != nullptr)
+                newTags[b] = (*tags)[status];
+            for (auto &[c, next]: table[status]) {
+                newTable[b][c] = block[next];
+            }
+        }
+        //状态0所在的块编号必然为0
+        this->startNode = block[0];
+        for (int &start : startStates)
+            start = block[start];
+        this->table = std::move(newTable);
+        this->statusMap = std::move(newStatusMap);
+        this->lookAccept = std::move(newLookAccept);
+        if (tags != nullptr)
+            *tags = std::move(newTags);
     }
 
-    //查看某个状态集合是否需要划分
-    bool DFA::needSplit(std::vector<hashSet<int>> &completeStatusSet,
-                        std::vector<hashSet<int>> &splitNotStatusSet, hashSet<int> &nextStatusSet) {
-        if (nextStatusSet.size() == 1) {
-            return false;
-        }
-        //先看completeStatusSet
-        //后看splitNotStatusSet
-        return !(isStatusSetInExistSet(completeStatusSet, nextStatusSet) ||
-                 isStatusSetInExistSet(splitNotStatusSet, nextStatusSet));
-    }
-
-    //划分nextStatusSet
-    void DFA::statusPartition(
-            std::vector<hashSet<int>> &completeStatusSet,
-            std::vector<hashSet<int>> &splitNotStatusSet, hashSet<int> &waitStatusSet, char c) {
-        //遍历nextStatusSet并查看各个状态在其余状态中的编号
-        std::vector<int> nextStatusList;
-        hashMap<int, int> currentNextStatusMap;
-        for (int status: waitStatusSet) {
-            //如果不存在c边则表示留在原状态
-            if (table[status].find(c) == table[status].end()) {
-                currentNextStatusMap[status] = status;
-            } else {
-                currentNextStatusMap[status] = table[status][c];
-            }
-        }
-        //对于nextStatusList,需要遍历completeStatusSet和splitNotStatusSet,找到他们各在那个集合中,用于划分
-        int completeStatusSetSize = (int) completeStatusSet.size();
-        int splitNotStatusSetSize = (int) splitNotStatusSet.size();
-        for (auto &[k, v]: currentNextStatusMap) {
-            bool flag = false;
-            for (int i = 0; i < completeStatusSetSize; i++) {
-                hashSet<int> &set = completeStatusSet[i];
-                if (set.find(v) != set.end()) {
-                    //找到nextStatus处在的集合,则令状态k为划分的i
-                    currentNextStatusMap[k] = i;
-                    flag = true;
-                    break;
+    //构造完成后计算各状态的附加信息
+    void DFA::finalize() {
+        int len = (int) table.size();
+        accel.assign(len, DFAAccel());
+        for (int status = 0; status < len; status++) {
+            //统计自环字节
+            bool loop[CHAR_MAX - CHAR_MIN + 1] = {false};
+            int loopCount = 0;
+            for (auto &[c, next]: table[status]) {
+                if (next == status) {
+                    loop[(uint8_t) c] = true;
+                    loopCount++;
                 }
             }
-            if (flag)
+            if (loopCount == 0)
                 continue;
-            for (int i = 0; i < splitNotStatusSetSize; i++) {
-                hashSet<int> &set = splitNotStatusSet[i];
-                if (set.find(v) != set.end()) {
-                    //找到nextStatus处在的集合,则令状态k为划分的i + completeStatusSetSize
-                    currentNextStatusMap[k] = i + completeStatusSetSize;
-                    break;
+            DFAAccel &info = accel[status];
+            if (CHAR_MAX - CHAR_MIN + 1 - loopCount <= 3) {
+                //逃逸字节不超过3个,可用memchr3式扫描
+                info.kind = DFAAccel::Kind::escapeBytes;
+                for (int b = 0; b <= CHAR_MAX - CHAR_MIN; b++) {
+                    if (!loop[b])
+                        info.bytes[info.count++] = (uint8_t) b;
+                }
+                continue;
+            }
+            //自环字节是否为连续区间
+            int lo = 0;
+            while (!loop[lo]) lo++;
+            int hi = lo;
+            while (hi + 1 <= CHAR_MAX - CHAR_MIN && loop[hi + 1]) hi++;
+            if (hi - lo + 1 == loopCount) {
+                info.kind = DFAAccel::Kind::loopRange;
+                info.lo = (uint8_t) lo;
+                info.hi = (uint8_t) hi;
+            }
+        }
+        //反向遍历求出可以到达终态的状态
+        std::vector<std::vector<int>> reverse(len);
+        for (int status = 0; status < len; status++) {
+            for (auto &[c, next]: table[status])
+                reverse[next].push_back(status);
+        }
+        std::vector<bool> live(len, false);
+        std::vector<int> liveStack;
+        for (int status = 0; status < len; status++) {
+            bool accepting = statusMap[status];
+            if (!lookAccept.empty()) {
+                for (uint64_t bits : lookAccept[status])
+                    accepting = accepting || bits != 0;
+            }
+            if (accepting) {
+                live[status] = true;
+                liveStack.push_back(status);
+            }
+        }
+        while (!liveStack.empty()) {
+            int status = liveStack.back();
+            liveStack.pop_back();
+            for (int prev : reverse[status]) {
+                if (!live[prev]) {
+                    live[prev] = true;
+                    liveStack.push_back(prev);
                 }
             }
         }
-        //再遍历一次currentNextStatusMap划分状态
-        hashMap<int, hashSet<int>> splitMap;
-        for (auto &[k, v]: currentNextStatusMap) {
-            splitMap[v].emplace(k);
+        //全接受状态:位于文本结尾时为终态,且任意字节都转移到全接受状态(最大不动点)
+        std::vector<bool> universal(len);
+        std::vector<int> rejectStack;
+        for (int status = 0; status < len; status++) {
+            universal[status] = statusMap[status] && table[status].size() == CHAR_MAX - CHAR_MIN + 1;
+            if (!universal[status])
+                rejectStack.push_back(status);
         }
-        splitNotStatusSet.pop_back();
-        for (auto &[k, v]: splitMap) {
-            splitNotStatusSet.emplace_back(v);
+        while (!rejectStack.empty()) {
+            int status = rejectStack.back();
+            rejectStack.pop_back();
+            for (int prev : reverse[status]) {
+                if (universal[prev]) {
+                    universal[prev] = false;
+                    rejectStack.push_back(prev);
+                }
+            }
+        }
+        for (int status = 0; status < len; status++) {
+            if (!live[status])
+                accel[status].kind = DFAAccel::Kind::dead;
+            else if (universal[status])
+                accel[status].kind = DFAAccel::Kind::universal;
         }
+        anchoredStart = true;
+        for (int context = Look::afterNewline; context < Look::contextCount; context++)
+            anchoredStart = anchoredStart && !live[startStates[context]];
+        //转为紧凑的转换表,并释放构造阶段的table
+        transitions = TransitionTable(table);
+        std::vector<hashMap<char, int>>().swap(table);
+        //最小化得到的编号取决于划分的顺序,改为广度优先顺序,使起始点附近的状态在表中相邻
+        applyLayout(canonicalOrder());
+        findRequiredBytes();
     }
 
-    //根据边划分
-    void DFA::statusPartition(hashSet<int> &waitStatusSet, char c, std::vector<hashSet<int>> &splitNotStatusSet) {
-        hashSet<int> containSet;
-        hashSet<int> notContainSet;
-        for (int status: waitStatusSet) {
-            if (table[status].find(c) != table[status].end()) {
-                containSet.emplace(status);
-            } else {
-                notContainSet.emplace(status);
-            }
-        }
-        splitNotStatusSet.pop_back();
-        splitNotStatusSet.emplace_back(containSet);
-        splitNotStatusSet.emplace_back(notContainSet);
-    }
-
-    //获取最小DFA(Hopcroft算法)
-    void DFA::getMinimizeDFA() {
-        //已划分好的状态集
-        std::vector<hashSet<int>> completeStatusSet;
-        //待划分的状态集
-        std::vector<hashSet<int>> splitNotStatusSet;
-        //先划分终态和非终态
-        hashSet<int> partfinalStatusSet;
-        hashSet<int> finalStatusSet;
-        hashSet<int> notFinalStatusSet;
-        for (int i = 0; i < statusMap.size(); i++) {
-            //对于不接收任何字符的终态,应该
-            if (statusMap[i]) {
-                finalStatusSet.emplace(i);
-                if (table[i].empty()) {
-                    hashSet<int> empty{i};
-                    completeStatusSet.emplace_back(empty);
-                    continue;
-                }
-                partfinalStatusSet.emplace(i);
-            } else {
-                notFinalStatusSet.emplace(i);
-            }
-        }
-        splitNotStatusSet.emplace_back(notFinalStatusSet);
-        splitNotStatusSet.emplace_back(partfinalStatusSet);
-        //然后从待划分的状态集合中继续划分集合
-        SPLIT:
-        while (!splitNotStatusSet.empty()) {
-            //从中选取一个待划分的集合
-            hashSet<int> &waitStatusSet = splitNotStatusSet[splitNotStatusSet.size() - 1];
-            //只剩一个状态时无需划分
-            if (waitStatusSet.size() == 1) {
-                completeStatusSet.emplace_back(waitStatusSet);
-                splitNotStatusSet.pop_back();
-                continue;
+    //广度优先顺序
+    std::vector<int> DFA::canonicalOrder() const {
+        int len = stateCount();
+        std::vector<int> order;
+        order.reserve(len);
+        std::vector<bool> visited(len, false);
+        auto visit = [&](int status) {
+            if (status >= 0 && !visited[status]) {
+                visited[status] = true;
+                order.push_back(status);
             }
-            bool splitFlag = false;
-            //先看waitStatusSet中的状态是否可通过边区分()
-            for (int i: waitStatusSet) {
-                for (int j: waitStatusSet) {
-                    for (auto &[c, s]: table[i]) {
-                        if (table[j].find(c) == table[j].end()) {
-                            //说明需要至少需要通过c来划分
-                            statusPartition(waitStatusSet, c, splitNotStatusSet);
-                            goto SPLIT;
-                        }
-                    }
+        };
+        visit(startNode);
+        for (int root: startStates)
+            visit(root);
+        //起始点之后再依次展开,保证startNode为0
+        for (size_t head = 0; head < order.size(); head++) {
+            for (int b = 0; b <= CHAR_MAX - CHAR_MIN; b++)
+                visit(transitions.next(order[head], (char) b));
+        }
+        //构造出的状态都可由起始点到达,这里只是保证order为排列
+        for (int status = 0; status < len; status++)
+            visit(status);
+        return order;
+    }
+
+    //结构指纹(FNV-1a):各状态的终态信息与按字节的转移,状态以其在order中的位置表示
+    uint64_t DFA::fingerprint(const std::vector<int> &order) const {
+        int len = stateCount();
+        std::vector<int> position(len);
+        for (int i = 0; i < len; i++)
+            position[order[i]] = i;
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        auto mix = [&hash](uint64_t value) {
+            hash = (hash ^ value) * 0x100000001b3ULL;
+        };
+        mix((uint64_t) len);
+        for (int root: startStates)
+            mix((uint64_t) position[root]);
+        for (int status: order) {
+            mix(statusMap[status]);
+            if (!lookAccept.empty()) {
+                for (uint64_t bits: lookAccept[status])
+                    mix(bits);
+            }
+            for (int b = 0; b <= CHAR_MAX - CHAR_MIN; b++) {
+                int next = transitions.next(status, (char) b);
+                mix(next < 0 ? ~0ULL : (uint64_t) position[next]);
+            }
+        }
+        return hash;
+    }
+
+    //重新编号,各状态的附加信息随状态一起移动
+    void DFA::applyLayout(const std::vector<int> &order) {
+        int len = stateCount();
+        std::vector<int> newId(len);
+        for (int i = 0; i < len; i++)
+            newId[order[i]] = i;
+        transitions.relabel(order, newId);
+        std::vector<bool> newStatusMap(len);
+        std::vector<DFAAccel> newAccel(len);
+        std::vector<ByteBitmap> newLookAccept(lookAccept.size());
+        for (int i = 0; i < len; i++) {
+            newStatusMap[i] = statusMap[order[i]];
+            newAccel[i] = accel[order[i]];
+            if (!lookAccept.empty())
+                newLookAccept[i] = lookAccept[order[i]];
+        }
+        statusMap.swap(newStatusMap);
+        accel.swap(newAccel);
+        lookAccept.swap(newLookAccept);
+        startNode = newId[startNode];
+        for (int &root: startStates)
+            root = newId[root];
+    }
+
+    //剖析,状态的走法与contains相同(不跳过加速态的自环,自环上的每个字节都计入)
+    void DFA::profile(std::string_view input, std::vector<uint64_t> &visits) const {
+        if (visits.size() < (size_t) stateCount())
+            visits.resize(stateCount(), 0);
+        int status = startNode;
+        visits[status]++;
+        for (size_t i = 0; i < input.size(); i++) {
+            int next = transitions.next(status, input[i]);
+            if (next < 0) {
+                status = i == 0 ? startNode : startStates[Look::contextOf(input[i - 1])];
+                next = transitions.next(status, input[i]);
+                if (next < 0)
+                    next = startStates[Look::contextOf(input[i])];
+            }
+            status = next;
+            visits[status]++;
+        }
+    }
+
+    //按剖析结果重新编号
+    void DFA::applyProfile(const std::vector<uint64_t> &visits) {
+        std::vector<int> order = canonicalOrder();
+        auto count = [&visits](int status) {
+            return (size_t) status < visits.size() ? visits[status] : 0;
+        };
+        std::stable_sort(order.begin() + 1, order.end(),
+                         [&count](int a, int b) { return count(a) > count(b); });
+        applyLayout(order);
+    }
+
+    //保存布局:每个位置上的状态的广度优先编号
+    void DFA::saveLayout(std::ostream &out) const {
+        std::vector<int> order = canonicalOrder();
+        std::vector<int> canonical(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+            canonical[order[i]] = (int) i;
+        out << "zhRegex-layout 1 " << stateCount() << " " << fingerprint(order) << "\n";
+        for (int status = 0; status < stateCount(); status++)
+            out << canonical[status] << (status + 1 == stateCount() ? "\n" : " ");
+    }
+
+    //读取布局
+    bool DFA::loadLayout(std::istream &in) {
+        std::string magic;
+        int version = 0, len = 0;
+        uint64_t hash = 0;
+        if (!(in >> magic >> version >> len >> hash) || magic != "zhRegex-layout" || version != 1 ||
+            len != stateCount())
+            return false;
+        std::vector<int> order = canonicalOrder();
+        if (hash != fingerprint(order))
+            return false;
+        //位置i上为广度优先编号saved[i]的状态
+        std::vector<int> layout(len);
+        std::vector<bool> used(len, false);
+        for (int i = 0; i < len; i++) {
+            int id;
+            if (!(in >> id) || id < 0 || id >= len || used[id])
+                return false;
+            used[id] = true;
+            layout[i] = order[id];
+        }
+        applyLayout(layout);
+        return true;
+    }
+
+    //占用的内存字节数
+    size_t DFA::memoryUsage() const {
+        std::shared_ptr<const DFA> built = std::atomic_load(&searcher);
+        return sizeof(DFA) + transitions.memoryUsage() + accel.capacity() * sizeof(DFAAccel) +
+               statusMap.capacity() / 8 + lookAccept.capacity() * sizeof(ByteBitmap) +
+               (built != nullptr ? built->memoryUsage() : 0);
+    }
+
+    //整个input字符串是否匹配pattern
+    bool DFA::match(std::string_view &input) {
+        int status = startNode;
+        const char *p = input.data();
+        const char *end = p + input.size();
+        while (p < end) {
+            //加速态直接跳过自环,死状态与全接受状态直接返回
+            if (accel[status].kind != DFAAccel::Kind::none) {
+                if (accel[status].kind == DFAAccel::Kind::dead)
+                    return false;
+                if (accel[status].kind == DFAAccel::Kind::universal)
+                    return true;
+                ZH_STATS_ONLY(const char *from = p);
+                p = skipLoop(status, p, end);
+                ZH_STATS_ADD(statsId, StatCounter::bytesSkipped, p - from);
+                if (p == end)
+                    break;
+            }
+            status = transitions.next(status, *p++);
+            if (status < 0) {
+                return false;
+            }
+        }
+        return statusMap[status];
+    }
+
+    // input是否存在匹配pattern的前缀,每读入一个字节前检查当前状态能否作为终态
+    bool DFA::matchPrefix(std::string_view &input) {
+        int status = startNode;
+        const char *p = input.data();
+        const char *end = p + input.size();
+        while (p < end) {
+            if (accel[status].kind != DFAAccel::Kind::none) {
+                if (accel[status].kind == DFAAccel::Kind::dead)
+                    return false;
+                if (accel[status].kind == DFAAccel::Kind::universal)
+                    return true;
+                //自环上的状态不变,不含零宽断言时能否作为终态与下一个字节无关,可以跳过
+                if (lookAccept.empty() && !statusMap[status]) {
+                    ZH_STATS_ONLY(const char *from = p);
+                    p = skipLoop(status, p, end);
+                    ZH_STATS_ADD(statsId, StatCounter::bytesSkipped, p - from);
+                    if (p == end)
+                        break;
                 }
             }
-            for (int c = CHAR_MIN; c <= CHAR_MAX; c++) {
-                // waitStatus经过c后会到达的集合即为nextStatusSet
-                hashSet<int> nextStatusSet;
-                for (int status: waitStatusSet) {
-                    if (table[status].find((char) c) == table[status].end()) {
-                        nextStatusSet.emplace(status);
-                    } else {
-                        nextStatusSet.emplace(table[status][(char) c]);
+            if (acceptBefore(status, *p))
+                return true;
+            status = transitions.next(status, *p++);
+            if (status < 0)
+                return false;
+        }
+        return statusMap[status];
+    }
+
+    //批量匹配,lanes个输入交错推进以隐藏查表延迟
+    template <int lanes>
+    void DFA::matchLanes(const std::string_view *inputs, size_t count, uint8_t *out) const {
+        size_t i = 0;
+        for (; i + lanes <= count; i += lanes) {
+            int status[lanes];
+            size_t common = inputs[i].size();
+            for (int l = 0; l < lanes; l++) {
+                status[l] = startNode;
+                common = std::min(common, inputs[i + l].size());
+            }
+            //公共长度内各输入互不依赖,交错查表
+            for (size_t k = 0; k < common; k++) {
+                int alive = 0;
+                for (int l = 0; l < lanes; l++) {
+                    if (status[l] >= 0) {
+                        status[l] = transitions.next(status[l], inputs[i + l][k]);
+                        alive |= status[l] >= 0;
                     }
                 }
-                //然后查看nextStatus是否在某个现行划分的集合中,如果需要划分则
-                if (needSplit(completeStatusSet, splitNotStatusSet, nextStatusSet)) {
-                    //调用statusPartition函数划分waitStatusSet
-                    statusPartition(completeStatusSet,
-                                    splitNotStatusSet, waitStatusSet, (char) c);
-                    splitFlag = true;
+                if (!alive)
                     break;
-                }
             }
-            //如果遍历后发现不需要划分,则
-            if (!splitFlag) {
-                completeStatusSet.emplace_back(waitStatusSet);
-                splitNotStatusSet.pop_back();
+            //各自走完剩余部分
+            for (int l = 0; l < lanes; l++) {
+                const std::string_view &input = inputs[i + l];
+                int s = status[l];
+                for (size_t k = common; k < input.size() && s >= 0; k++) {
+                    s = transitions.next(s, input[k]);
+                }
+                out[i + l] = s >= 0 && statusMap[s];
             }
         }
-        //根据新的集合创建table
-        //原table状态status对应的现在的状态
-        int len = (int) completeStatusSet.size();
-        hashMap<int, int> tableStatusMap;
-        for (int i = 0; i < len; i++) {
-            hashSet<int> &statusSet = completeStatusSet[i];
-            //每个状态应该转到哪一个状态去
-            for (int status: statusSet) {
-                tableStatusMap[status] = i;
+        for (; i < count; i++) {
+            int s = startNode;
+            for (size_t k = 0; k < inputs[i].size() && s >= 0; k++) {
+                s = transitions.next(s, inputs[i][k]);
             }
+            out[i] = s >= 0 && statusMap[s];
         }
-        //重构table后起始点会改变
-        std::vector<hashMap<char, int>> newTable(len, hashMap<char, int>(CHAR_MAX - CHAR_MIN + 1));
-        std::vector<bool> newStatusMap(len, false);
-        //新的table应该从各个状态集合中选取代表
-        for (int i = 0; i < len; i++) {
-            hashSet<int> &statusSet = completeStatusSet[i];
-            //每个状态应该转到哪一个状态去
-            for (int status: statusSet) {
-                for (int c = CHAR_MIN; c <= CHAR_MAX; c++) {
-                    //原table状态转到的status对应的现在的map
-                    if (table[status].find((char) c) != table[status].end()) {
-                        int nextStatus = table[status][(char) c];
-                        newTable[i][(char) c] = tableStatusMap[nextStatus];
+    }
+
+    //批量匹配
+    void DFA::matchBatch(const std::string_view *inputs, size_t count, uint8_t *out, int lanes) {
+        if (lanes >= 16)
+            matchLanes<16>(inputs, count, out);
+        else if (lanes >= 8)
+            matchLanes<8>(inputs, count, out);
+        else if (lanes >= 4)
+            matchLanes<4>(inputs, count, out);
+        else if (lanes >= 2)
+            matchLanes<2>(inputs, count, out);
+        else
+            matchLanes<1>(inputs, count, out);
+    }
+
+    //初始化一个分块的lane:fromStart为true时只从起始点出发,否则从每个状态出发
+    void DFA::initChunkLanes(ChunkLanes &chunk, const char *base, bool fromStart) const {
+        int n = transitions.size();
+        chunk.base = base;
+        chunk.entryLane.assign(n, -1);
+        chunk.status.clear();
+        if (fromStart) {
+            chunk.entryLane[startNode] = 0;
+            chunk.status.emplace_back(startNode);
+            return;
+        }
+        for (int s = 0; s < n; s++) {
+            chunk.entryLane[s] = s;
+            chunk.status.emplace_back(s);
+        }
+    }
+
+    //各分块同步推进[offset,offset + length),每个分块内的lane互不依赖,交错查表
+    //每推进一段后合并状态相同的lane并去掉死亡的lane,大多数DFA很快就会收敛为一条
+    void DFA::advanceChunkLanes(ChunkLanes *chunks, int chunkCount, size_t offset, size_t length) const {
+        constexpr size_t mergeInterval = 64;
+        std::vector<int> owner(transitions.size(), -1);
+        std::vector<int> remap;
+        for (size_t k = 0; k < length; k += mergeInterval) {
+            size_t stop = std::min(length, k + mergeInterval);
+            for (size_t i = offset + k; i < offset + stop; i++) {
+                for (int j = 0; j < chunkCount; j++) {
+                    char c = chunks[j].base[i];
+                    int *status = chunks[j].status.data();
+                    int lanes = (int) chunks[j].status.size();
+                    for (int l = 0; l < lanes; l++) {
+                        status[l] = status[l] >= 0 ? transitions.next(status[l], c) : -1;
                     }
                 }
-                //为终态则令其为true
-                if (finalStatusSet.find(status) != finalStatusSet.end()) {
-                    newStatusMap[i] = true;
+            }
+            for (int j = 0; j < chunkCount; j++) {
+                ChunkLanes &chunk = chunks[j];
+                int lanes = (int) chunk.status.size();
+                int kept = 0;
+                remap.assign(lanes, -1);
+                for (int l = 0; l < lanes; l++) {
+                    int s = chunk.status[l];
+                    if (s < 0)
+                        continue;
+                    if (owner[s] < 0) {
+                        owner[s] = kept;
+                        chunk.status[kept++] = s;
+                    }
+                    remap[l] = owner[s];
+                }
+                chunk.status.resize(kept);
+                for (int s: chunk.status) {
+                    owner[s] = -1;
+                }
+                for (int &lane: chunk.entryLane) {
+                    if (lane >= 0)
+                        lane = remap[lane];
                 }
             }
         }
-        int start = tableStatusMap[0];
-        this->startNode = start;
-        this->table = newTable;
-        this->statusMap = newStatusMap;
     }
 
-    //整个input字符串是否匹配pattern
-    bool DFA::match(std::string_view &input) {
+    //将input切分为chunks块同步推进后判断是否整体匹配
+    //除第一块外其余块不知道入口状态,因此从每个状态出发推进,最后按顺序拼接
+    bool DFA::matchChunked(std::string_view &input, int chunks, unsigned threads) {
+        //状态过多时枚举代价过高
+        constexpr int maxEnumerateStates = 64;
+        constexpr size_t minChunkSize = 256;
+        if (chunks <= 1 || transitions.size() > maxEnumerateStates || input.size() < chunks * minChunkSize)
+            return match(input);
+        size_t step = input.size() / chunks;
+        std::vector<ChunkLanes> lanes(chunks);
+        for (int j = 0; j < chunks; j++) {
+            initChunkLanes(lanes[j], input.data() + j * step, j == 0);
+        }
+        //每个线程负责连续的若干块
+        int workers = (int) std::max(1u, std::min<unsigned>(threads, chunks));
+        int perWorker = (chunks + workers - 1) / workers;
+        std::vector<std::thread> pool;
+        for (int first = perWorker; first < chunks; first += perWorker) {
+            int count = std::min(perWorker, chunks - first);
+            pool.emplace_back([this, &lanes, first, count, step]() {
+                advanceChunkLanes(lanes.data() + first, count, 0, step);
+            });
+        }
+        advanceChunkLanes(lanes.data(), std::min(perWorker, chunks), 0, step);
+        for (auto &t: pool) {
+            t.join();
+        }
+        //最后一块还需推进除不尽的剩余部分
+        advanceChunkLanes(&lanes[chunks - 1], 1, step, input.size() - chunks * step);
+        //依次拼接
         int status = startNode;
-        for (char c: input) {
-            if (table[status].find(c) == table[status].end()) {
+        for (auto &chunk: lanes) {
+            int lane = chunk.entryLane[status];
+            if (lane < 0)
                 return false;
-            }
-            status = table[status][c];
+            status = chunk.status[lane];
         }
         return statusMap[status];
     }
 
-    //找出所有匹配的string
-    std::vector<std::string_view> DFA::contains(std::string_view &input) {
+    //依次报告所有匹配的位置
+    //含零宽断言时,失配位置的终态判断依赖下一个字节,重新开始时的起始点依赖前一个字节
+    template <typename Emit>
+    void DFA::forEachMatch(std::string_view input, Emit &&emit) const {
         int status = startNode;
         int len = (int) input.size();
-        std::vector<std::string_view> ans;
         int index = 0;
         for (int i = 0; i < len; i++) {
+            //加速态直接跳过自环,此时状态不变且不会产生匹配
+            if (accel[status].kind != DFAAccel::Kind::none) {
+                //全接受状态必然一直匹配到文本结尾
+                if (accel[status].kind == DFAAccel::Kind::universal)
+                    break;
+                //锚定时死状态之后不可能再匹配
+                if (accel[status].kind == DFAAccel::Kind::dead && anchoredStart)
+                    return;
+                ZH_STATS_ONLY(int from = i);
+                i = (int) (skipLoop(status, input.data() + i, input.data() + len) - input.data());
+                ZH_STATS_ADD(statsId, StatCounter::bytesSkipped, i - from);
+                if (i == len)
+                    break;
+            }
             //当发现不匹配时
-            if (table[status].find(input[i]) == table[status].end()) {
+            int next = transitions.next(status, input[i]);
+            if (next < 0) {
                 //如果当前状态可作为终结状态,则插入
-                if (statusMap[status]) {
+                if (acceptBefore(status, input[i])) {
                     //大小应该从index出发截止到i - 1的位置
-                    std::string_view s = input.substr(index, i - index);
-                    ans.emplace_back(s);
+                    emit((size_t) index, (size_t) (i - index));
                 }
+                //锚定在文本开头时,之后不可能再匹配
+                if (anchoredStart && i > 0)
+                    return;
                 //之后更新index并重置状态为初始状态
                 // index应该从当前这个不匹配的字符开始算起
                 index = i;
-                status = startNode;
+                status = i == 0 ? startNode : startStates[Look::contextOf(input[i - 1])];
+                next = transitions.next(status, input[i]);
             }
-            if (table[status].find(input[i]) != table[status].end()) {
-                status = table[status][input[i]];
+            if (next >= 0) {
+                status = next;
             } else {
+                if (anchoredStart)
+                    return;
                 index = i + 1;
+                status = startStates[Look::contextOf(input[i])];
             }
         }
-        if (statusMap[status]) {
-            std::string_view s = input.substr(index, len - index + 1);
-            ans.emplace_back(s);
-        }
+        if (statusMap[status])
+            emit((size_t) index, (size_t) (len - index));
+    }
+
+    //找出所有匹配的string
+    std::vector<std::string_view> DFA::contains(std::string_view &input) {
+        std::vector<std::string_view> ans;
+        forEachMatch(input, [&](size_t offset, size_t length) { ans.emplace_back(input.substr(offset, length)); });
         return ans;
     }
-}  // namespace zhRegex
\ No newline at end of file
+
+    //找出所有匹配,直接写入out
+    void DFA::contains(std::string_view input, MatchBuffer &out, uint32_t patternId) {
+        forEachMatch(input, [&](size_t offset, size_t length) { out.push(offset, length, patternId); });
+    }
+
+    //删去某个字节类的全部边后,若从任何起始点都无法到达终态,则每个匹配必然经过该类中的字节
+    //逐类检查需要O(类数 * 状态数 * 类数),状态过多时放弃
+    void DFA::findRequiredBytes() {
+        requiredCount = 0;
+        int len = stateCount();
+        int classCount = transitions.classes();
+        if (len == 0 || (size_t) len * classCount * classCount > ((size_t) 1 << 22))
+            return;
+        std::vector<int> classSize(classCount, 0);
+        std::vector<char> firstByte(classCount);
+        for (int b = 255; b >= 0; b--) {
+            int cls = transitions.byteClass((char) b);
+            classSize[cls]++;
+            firstByte[cls] = (char) b;
+        }
+        std::vector<bool> visited(len);
+        std::vector<int> stack;
+        int best = -1;
+        for (int cls = 0; cls < classCount; cls++) {
+            if (classSize[cls] > 3 || (best >= 0 && classSize[cls] >= classSize[best]))
+                continue;
+            visited.assign(len, false);
+            stack.clear();
+            for (int start : startStates) {
+                if (!visited[start]) {
+                    visited[start] = true;
+                    stack.push_back(start);
+                }
+            }
+            bool reachable = false;
+            while (!stack.empty() && !reachable) {
+                int status = stack.back();
+                stack.pop_back();
+                reachable = acceptsSomeByte(status) || statusMap[status];
+                for (int other = 0; other < classCount && !reachable; other++) {
+                    int next = other == cls ? -1 : transitions.nextByClass(status, other);
+                    if (next >= 0 && !visited[next]) {
+                        visited[next] = true;
+                        stack.push_back(next);
+                    }
+                }
+            }
+            if (!reachable)
+                best = cls;
+        }
+        if (best < 0)
+            return;
+        for (int b = 0; b < 256; b++) {
+            if (transitions.byteClass((char) b) == best)
+                requiredBytes[requiredCount++] = (uint8_t) b;
+        }
+    }
+
+    //状态集合由原DFA的状态组成:经过字节c后为各状态的后继,再加上c之后的起始点(即在下一个位置重新开始)
+    //死状态不可能再到达终态,直接去掉;不含零宽断言时,含终态的集合已经可以判定匹配,令其任意字节都转移到自身,
+    //最小化后合并为一个全接受状态
+    std::shared_ptr<const DFA> DFA::buildSearcher() const {
+        std::shared_ptr<DFA> result(new DFA());
+        ZH_STATS_ONLY(result->statsId = statsId);
+        bool hasLook = !lookAccept.empty();
+        //原转换表的字节类,含零宽断言时还要按重新开始的起始点与各状态的lookAccept细分
+        ByteClasses classes;
+        std::vector<uint32_t> keys(256);
+        for (int b = 0; b < 256; b++)
+            keys[b] = (uint32_t) transitions.byteClass((char) b);
+        classes.refine(keys);
+        if (hasLook) {
+            for (int b = 0; b < 256; b++)
+                keys[b] = (uint32_t) startStates[Look::contextOf((char) b)];
+            classes.refine(keys);
+            std::vector<ByteBitmap> bitmaps(lookAccept.begin(), lookAccept.end());
+            std::sort(bitmaps.begin(), bitmaps.end());
+            bitmaps.erase(std::unique(bitmaps.begin(), bitmaps.end()), bitmaps.end());
+            for (const ByteBitmap &bits : bitmaps) {
+                for (int b = 0; b < 256; b++)
+                    keys[b] = (uint32_t) ((bits[b >> 6] >> (b & 63)) & 1);
+                classes.refine(keys);
+            }
+        }
+        auto isFinal = [&](const std::vector<uint32_t> &states) {
+            for (uint32_t status : states) {
+                if (statusMap[status])
+                    return true;
+            }
+            return false;
+        };
+        auto expand = [&](unsigned, const std::vector<uint32_t> &states, SubsetSuccessors &successors,
+                          std::vector<int> &acceptClasses) {
+            if (!hasLook && isFinal(states)) {
+                for (int cls = 0; cls < classes.count(); cls++)
+                    successors.emplace_back(cls, states);
+                return;
+            }
+            for (int cls = 0; cls < classes.count(); cls++) {
+                char c = classes.bytesOf(cls)[0];
+                std::vector<uint32_t> nextStates;
+                bool accept = false;
+                for (uint32_t status : states) {
+                    accept = accept || (hasLook && acceptBefore((int) status, c));
+                    int next = transitions.next((int) status, c);
+                    if (next >= 0 && accel[next].kind != DFAAccel::Kind::dead)
+                        nextStates.push_back((uint32_t) next);
+                }
+                int restart = startStates[Look::contextOf(c)];
+                if (accel[restart].kind != DFAAccel::Kind::dead)
+                    nextStates.push_back((uint32_t) restart);
+                std::sort(nextStates.begin(), nextStates.end());
+                nextStates.erase(std::unique(nextStates.begin(), nextStates.end()), nextStates.end());
+                if (accept)
+                    acceptClasses.push_back(cls);
+                //空集合也要保留:之后的字节可能使起始点不再是死状态(如\Bb在空格之后)
+                successors.emplace_back(cls, std::move(nextStates));
+            }
+        };
+        //集合个数最坏为原状态数的指数,超出限制时放弃
+        CompileLimits limits;
+        limits.maxDFAStates = std::max<size_t>(4096, (size_t) stateCount() * 8);
+        CompileBudget budget(limits);
+        try {
+            std::vector<int> startIds = buildSubsets(classes, {{(uint32_t) startNode}}, 1, expand, isFinal,
+                                                     result->table, result->statusMap,
+                                                     hasLook ? &result->lookAccept : nullptr, &budget);
+            result->startNode = startIds[0];
+            for (int &start : result->startStates)
+                start = startIds[0];
+            result->getMinimizeDFA(&budget);
+        } catch (const RegexException &e) {
+            if (!e.isLimit())
+                throw;
+            return std::shared_ptr<const DFA>(new DFA());
+        }
+        result->finalize();
+        return result;
+    }
+
+    //与matchPrefix相同,但非锚定DFA在每个位置都已重新开始
+    bool DFA::scanAnywhere(std::string_view input) const {
+        int status = startNode;
+        const char *p = input.data();
+        const char *end = p + input.size();
+        while (p < end) {
+            if (accel[status].kind != DFAAccel::Kind::none) {
+                if (accel[status].kind == DFAAccel::Kind::dead)
+                    return false;
+                if (accel[status].kind == DFAAccel::Kind::universal)
+                    return true;
+                //自环上不可能作为终态时可以跳过
+                if (!acceptsSomeByte(status)) {
+                    ZH_STATS_ONLY(const char *from = p);
+                    p = skipLoop(status, p, end);
+                    ZH_STATS_ADD(statsId, StatCounter::bytesSkipped, p - from);
+                    if (p == end)
+                        break;
+                }
+            }
+            if (acceptBefore(status, *p))
+                return true;
+            status = transitions.next(status, *p++);
+            if (status < 0)
+                return false;
+        }
+        return statusMap[status];
+    }
+
+    //状态集合用时间戳去重
+    bool DFA::anywhereBySets(std::string_view input) const {
+        std::vector<int> current{startNode};
+        std::vector<int> next;
+        std::vector<uint32_t> marks(stateCount(), 0);
+        uint32_t stamp = 0;
+        for (char c : input) {
+            stamp++;
+            next.clear();
+            for (int status : current) {
+                if (accel[status].kind == DFAAccel::Kind::universal || acceptBefore(status, c))
+                    return true;
+                int target = transitions.next(status, c);
+                if (target >= 0 && accel[target].kind != DFAAccel::Kind::dead && marks[target] != stamp) {
+                    marks[target] = stamp;
+                    next.push_back(target);
+                }
+            }
+            int restart = startStates[Look::contextOf(c)];
+            if (accel[restart].kind != DFAAccel::Kind::dead && marks[restart] != stamp)
+                next.push_back(restart);
+            current.swap(next);
+        }
+        for (int status : current) {
+            if (statusMap[status])
+                return true;
+        }
+        return false;
+    }
+
+    // input中是否存在匹配
+    bool DFA::isMatchAnywhere(std::string_view input) {
+        const char *end = input.data() + input.size();
+        if (requiredCount > 0 && findAnyOf(input.data(), end, requiredBytes, requiredCount) == end) {
+            ZH_STATS_ADD(statsId, StatCounter::prefilterRejects, 1);
+            return false;
+        }
+        //锚定时只有从文本开头开始的匹配,即是否存在匹配的前缀
+        if (anchoredStart)
+            return matchPrefix(input);
+        std::shared_ptr<const DFA> built = std::atomic_load(&searcher);
+        if (built == nullptr) {
+            //多个线程同时构造时结果相同,保留任意一个即可
+            built = buildSearcher();
+            std::atomic_store(&searcher, built);
+        }
+        return built->stateCount() > 0 ? built->scanAnywhere(input) : anywhereBySets(input);
+    }
+
+    // contains找到的匹配个数
+    size_t DFA::count(std::string_view input) {
+        const char *end = input.data() + input.size();
+        if (requiredCount > 0 && findAnyOf(input.data(), end, requiredBytes, requiredCount) == end) {
+            ZH_STATS_ADD(statsId, StatCounter::prefilterRejects, 1);
+            return 0;
+        }
+        size_t matches = 0;
+        forEachMatch(input, [&](size_t, size_t) { matches++; });
+        return matches;
+    }
+}  // namespace zhRegex
@@ -1,82 +1,204 @@
 #ifndef _ZH_DFA_H_
 #define _ZH_DFA_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <thread>
+
+#include "ByteScan.h"
 #include "NFA.h"
+#include "PositionNFA.h"
+#include "TransitionTable.h"
 
 namespace zhRegex {
-    // MapHash和MapEqual
-    struct DFAMapHash {
-        size_t operator()(const hashSet<NFANode *> &set) const {
-            size_t ans = 0;
-            for (NFANode *node : set) {
-                ans ^= std::hash<char>()(node->edgeValue);
-                ans ^= std::hash<int>()(static_cast<int>(node->edgeType));
-                if (node->edgeSet != nullptr) {
-                    for (char c : *(node->edgeSet)) {
-                        ans ^= std::hash<char>()(c);
-                    }
-                }
-            }
-            return ans;
-        }
-    };
-
-    struct DFAMapEqual {
-        bool operator()(const hashSet<NFANode *> &set1, const hashSet<NFANode *> &set2) const noexcept {
-            if (set1.size() != set2.size()) {
-                return false;
-            }
-            return set1 == set2;
-        }
+    //加速态:自环覆盖了绝大多数字节的状态(如[0-9]+,.*产生的环),可借助SIMD直接跳过自环
+    //死状态与全接受状态(如abc.*读完abc之后)也记录在这里,匹配时只在kind != none时才需要额外判断
+    struct DFAAccel {
+        enum class Kind : uint8_t {
+            none,         //不可加速
+            escapeBytes,  //离开该状态的字节不超过3个
+            loopRange,    //自环字节为连续区间[lo,hi]
+            dead,         //不可能再到达终态,匹配可以直接失败
+            universal     //任意后续输入都可作为终态,匹配可以直接成功
+        };
+        Kind kind = Kind::none;
+        //逃逸字节个数及逃逸字节
+        uint8_t count = 0;
+        uint8_t bytes[3]{};
+        //自环区间
+        uint8_t lo = 0;
+        uint8_t hi = 0;
     };
 
     //确定有限状态机
     class DFA : public Pattern {
     private:
-        // table表用于状态转换
+        // table表用于构造阶段的状态转换,finalize()后转为transitions并释放
         std::vector<hashMap<char, int>> table;
+        //紧凑的状态转换表,匹配时使用
+        TransitionTable transitions;
         // statusMap用于指示否个状态是否为最终状态
         std::vector<bool> statusMap;
         //起始点
         int startNode{0};
+        //在前一个字节的种类为Look::Context时重新开始匹配的起始点,不含零宽断言时均为startNode
+        int startStates[Look::contextCount]{};
+        //含零宽断言时,lookAccept[s]为状态s在下一个字节为哪些字节时可作为终态,此时statusMap表示位于文本结尾时是否为终态
+        std::vector<ByteBitmap> lookAccept;
+        //除文本开头外的起始点都不可能到达终态,contains无需在文本中间重新开始
+        bool anchoredStart = false;
+        //每个状态的加速信息,由finalize()计算
+        std::vector<DFAAccel> accel;
+        //预过滤:任何匹配都至少包含其中一个字节,requiredCount为0表示没有这样的字节(不超过3个)
+        uint8_t requiredBytes[3]{};
+        uint8_t requiredCount = 0;
+        // isMatchAnywhere使用的非锚定DFA(相当于.*(pattern)),首次使用时构造,可被多个线程同时读取
+        //状态数超出限制时为空DFA,改为直接模拟原DFA的状态集合
+        mutable std::shared_ptr<const DFA> searcher;
         //友元
         friend class NFA;
+        friend class PositionNFA;
+        friend class LineSearcher;
+        friend class Tokenizer;
 
     private:
-        //判断是否存在最终状态
-        static bool isFinalStatus(hashSet<NFANode *> &closureSet);
+        //获取最小DFA(Hopcroft划分细化),budget不为空时定期检查耗时
+        //分割者队列的处理是串行的,不做并行的划分细化:O(n·k·log n)的串行细化已远快于逐轮并行计算签名
+        // tags不为空时为每个状态的标记(如词法规则编号),标记不同的状态不会合并,结果按新编号写回
+        void getMinimizeDFA(const CompileBudget *budget = nullptr, std::vector<int> *tags = nullptr);
+        //构造完成后计算各状态的附加信息(加速态、死状态、全接受状态、锚定等),并按广度优先顺序重新编号
+        void finalize();
+        //从startNode开始按字节升序广度优先遍历(之后依次为其余起始点),返回第k个访问到的状态,结果与当前编号无关
+        std::vector<int> canonicalOrder() const;
+        //按canonicalOrder的编号计算结构指纹,用于校验保存的布局
+        uint64_t fingerprint(const std::vector<int> &order) const;
+        //重新编号:新状态i为旧状态order[i]
+        void applyLayout(const std::vector<int> &order);
+        //求预过滤的必需字节
+        void findRequiredBytes();
+        //对原DFA的状态集合做子集构造,得到每个位置都重新开始匹配的非锚定DFA并最小化
+        std::shared_ptr<const DFA> buildSearcher() const;
+        //在非锚定DFA上扫描input,到达终态即返回true
+        bool scanAnywhere(std::string_view input) const;
+        //非锚定DFA过大时,同时推进原DFA的多个状态
+        bool anywhereBySets(std::string_view input) const;
 
-        //查看某个状态集合是否在现行已划分的集合中
-        static bool isStatusSetInExistSet(std::vector<hashSet<int>> &existStatusSet,
-                                          hashSet<int> &nextStatusSet);
+        //matchChunked中一个分块的状态:从各入口状态出发的lane
+        struct ChunkLanes {
+            //分块起始位置
+            const char *base = nullptr;
+            //每条lane的当前状态,-1表示已死亡
+            std::vector<int> status;
+            //入口状态 -> lane,-1表示该入口已死亡
+            std::vector<int> entryLane;
+        };
 
-        //查看某个状态集合是否需要划分
-        static bool needSplit(std::vector<hashSet<int>> &completeStatusSet,
-                              std::vector<hashSet<int>> &splitNotStatusSet, hashSet<int> &nextStatusSet);
+        //批量匹配,lanes个输入交错推进
+        template <int lanes>
+        void matchLanes(const std::string_view *inputs, size_t count, uint8_t *out) const;
+        //初始化一个分块的lane
+        void initChunkLanes(ChunkLanes &chunk, const char *base, bool fromStart) const;
+        //各分块同步推进[offset,offset + length)
+        void advanceChunkLanes(ChunkLanes *chunks, int chunkCount, size_t offset, size_t length) const;
+        //contains的实现,对每个匹配调用emit(偏移, 长度)
+        template <typename Emit>
+        void forEachMatch(std::string_view input, Emit &&emit) const;
 
-        //划分waitStatusSet
-        void statusPartition(std::vector<hashSet<int>> &completeStatusSet,
-                             std::vector<hashSet<int>> &splitNotStatusSet, hashSet<int> &waitStatusSet, char c);
+        //从加速态status出发跳过自环,返回第一个可能离开status的位置
+        inline const char *skipLoop(int status, const char *p, const char *end) const {
+            const DFAAccel &info = accel[status];
+            switch (info.kind) {
+            case DFAAccel::Kind::escapeBytes:
+                return findAnyOf(p, end, info.bytes, info.count);
+            case DFAAccel::Kind::loopRange:
+                return findNotInRange(p, end, info.lo, info.hi);
+            default:
+                return p;
+            }
+        }
 
-        //根据边划分
-        void statusPartition(hashSet<int> &waitStatusSet, char c, std::vector<hashSet<int>> &splitNotStatusSet);
-        //获取最小DFA(Hopcroft算法)
-        void getMinimizeDFA();
+        // status是否在下一个字节为某些字节时可作为终态
+        inline bool acceptsSomeByte(int status) const {
+            if (lookAccept.empty())
+                return statusMap[status];
+            const ByteBitmap &bits = lookAccept[status];
+            return (bits[0] | bits[1] | bits[2] | bits[3]) != 0;
+        }
+
+        //下一个字节为c时status能否作为终态
+        inline bool acceptBefore(int status, char c) const {
+            if (lookAccept.empty())
+                return statusMap[status];
+            return (lookAccept[status][(uint8_t) c >> 6] >> ((uint8_t) c & 63)) & 1;
+        }
 
         DFA() = default;
+        //由pattern构造,construction指定NFA的构造方式
+        void compile(std::string_view &pattern, bool getMINDFA, NFAConstruction construction, unsigned threads,
+                     unsigned flags, const CompileLimits &limits);
 
     public:
-        explicit DFA(const char *pattern, bool getMINDFA = true);
-        explicit DFA(std::string &pattern, bool getMINDFA = true);
-        explicit DFA(std::string_view &pattern, bool getMINDFA = true);
-        explicit DFA(NFA &nfaMachine, bool getMINDFA = true);
+        //threads > 1时子集构造使用多线程,得到的DFA与单线程时完全相同;最小化始终在调用线程中进行
+        //超出limits时抛出isLimit()为true的RegexException,可改用NFA模拟(见Regex::compile)
+        explicit DFA(const char *pattern, bool getMINDFA = true,
+                     NFAConstruction construction = NFAConstruction::thompson, unsigned threads = 1,
+                     unsigned flags = RegexFlags::none, const CompileLimits &limits = CompileLimits());
+        explicit DFA(std::string &pattern, bool getMINDFA = true,
+                     NFAConstruction construction = NFAConstruction::thompson, unsigned threads = 1,
+                     unsigned flags = RegexFlags::none, const CompileLimits &limits = CompileLimits());
+        explicit DFA(std::string_view &pattern, bool getMINDFA = true,
+                     NFAConstruction construction = NFAConstruction::thompson, unsigned threads = 1,
+                     unsigned flags = RegexFlags::none, const CompileLimits &limits = CompileLimits());
+        explicit DFA(NFA &nfaMachine, bool getMINDFA = true, unsigned threads = 1,
+                     const CompileLimits &limits = CompileLimits());
+        explicit DFA(PositionNFA &nfaMachine, bool getMINDFA = true, unsigned threads = 1,
+                     const CompileLimits &limits = CompileLimits());
         ~DFA() override = default;
+        //析构函数已声明,显式保留移动操作,vector扩容与赋值时不必复制整张转换表
+        DFA(const DFA &) = default;
+        DFA(DFA &&) = default;
+        DFA &operator=(const DFA &) = default;
+        DFA &operator=(DFA &&) = default;
 
         //整个input字符串是否匹配pattern
         bool match(std::string_view &input) override;
+        // input是否存在匹配pattern的前缀,到达死状态或全接受状态时立即返回
+        bool matchPrefix(std::string_view &input) override;
 
         //找出所有匹配的string
         std::vector<std::string_view> contains(std::string_view &input) override;
+        //找出所有匹配,直接写入out
+        void contains(std::string_view input, MatchBuffer &out, uint32_t patternId = 0) override;
+
+        // input中是否存在匹配,先用必需字节预过滤,再扫描非锚定DFA
+        bool isMatchAnywhere(std::string_view input) override;
+        //contains找到的匹配个数
+        size_t count(std::string_view input) override;
+
+        //占用的内存字节数
+        size_t memoryUsage() const override;
+
+        //剖析:按contains的方式扫描input,累加各状态的访问次数到visits(按状态编号,长度不足时扩展)
+        void profile(std::string_view input, std::vector<uint64_t> &visits) const;
+        //按访问次数从高到低重新编号,起始点固定为0,次数相同时保持广度优先顺序,使热点状态集中在转换表开头的缓存行
+        void applyProfile(const std::vector<uint64_t> &visits);
+        //保存当前的状态排列,以与编号无关的广度优先编号表示,可由同一pattern重新编译得到的DFA读取
+        void saveLayout(std::ostream &out) const;
+        //读取saveLayout保存的排列并应用,格式错误或与当前DFA的结构不符时返回false且不做修改
+        bool loadLayout(std::istream &in);
+
+        //批量匹配,lanes个输入交错推进以隐藏查表延迟
+        void matchBatch(const std::string_view *inputs, size_t count, uint8_t *out, int lanes) override;
+
+        //将input切分为chunks块同步推进后判断是否整体匹配,threads > 1时各块由多个线程处理
+        bool matchChunked(std::string_view &input, int chunks, unsigned threads) override;
+
+        //状态个数
+        inline int stateCount() const {
+            return transitions.size();
+        }
     };
 }  // namespace zhRegex
 
@@ -0,0 +1,386 @@
+#include "DiffFuzz.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+
+#include "DFA.h"
+#include "MatchBuffer.h"
+
+namespace zhRegex {
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        struct Engine {
+            std::string name;
+            std::unique_ptr<Pattern> pattern;
+        };
+
+        //一个pattern的全部引擎,reference(由未化简的AST构造的NFA模拟)为基准
+        struct EngineSet {
+            std::unique_ptr<NFA> reference;
+            std::vector<Engine> engines;
+            //最小DFA单线程与多线程构造的状态数,二者应当相同
+            int states = 0;
+            int threadedStates = 0;
+            double seconds = 0;
+        };
+
+        //构造全部引擎,pattern只解析一次;基准由未化简的AST构造,其余引擎都由ASTOptimizer化简后的AST构造,
+        //因此化简引入的错误也会表现为不一致;PositionNFA不支持断言,此时跳过Glushkov构造的引擎
+        EngineSet build(const std::string &pattern, unsigned flags, const CompileLimits &limits) {
+            auto begin = Clock::now();
+            EngineSet set;
+            std::string_view view = pattern;
+            Parser parser(view, flags);
+            RegexAST ast = parser.parse();
+            CompileBudget referenceBudget(limits);
+            set.reference = std::make_unique<NFA>(ast, &referenceBudget);
+            ASTOptimizer::optimize(ast);
+            CompileBudget budget(limits);
+            auto thompson = std::make_unique<NFA>(ast, &budget);
+            set.engines.push_back(Engine{"dfa", std::make_unique<DFA>(*thompson, false, 1, limits)});
+            auto minimized = std::make_unique<DFA>(*thompson, true, 1, limits);
+            auto threaded = std::make_unique<DFA>(*thompson, true, 2, limits);
+            set.states = minimized->stateCount();
+            set.threadedStates = threaded->stateCount();
+            set.engines.push_back(Engine{"nfa", std::move(thompson)});
+            set.engines.push_back(Engine{"min-dfa", std::move(minimized)});
+            set.engines.push_back(Engine{"min-dfa-mt", std::move(threaded)});
+            try {
+                auto glushkov = std::make_unique<PositionNFA>(ast, &budget);
+                auto glushkovDFA = std::make_unique<DFA>(*glushkov, true, 1, limits);
+                set.engines.push_back(Engine{"glushkov", std::move(glushkov)});
+                set.engines.push_back(Engine{"glushkov-dfa", std::move(glushkovDFA)});
+            } catch (const RegexException &e) {
+                if (e.code != RegexErrorCode::unsupported)
+                    throw;
+            }
+            set.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+            return set;
+        }
+
+        //两组匹配的位置是否完全相同
+        bool samePositions(const std::vector<std::string_view> &a, const std::vector<std::string_view> &b) {
+            if (a.size() != b.size())
+                return false;
+            for (size_t i = 0; i < a.size(); i++) {
+                if (a[i].data() != b[i].data() || a[i].size() != b[i].size())
+                    return false;
+            }
+            return true;
+        }
+
+        bool samePositions(const MatchBuffer &buffer, std::string_view input, const std::vector<std::string_view> &b) {
+            if (buffer.size() != b.size())
+                return false;
+            for (size_t i = 0; i < b.size(); i++) {
+                if (buffer.offset(i) != (size_t) (b[i].data() - input.data()) || buffer.length(i) != b[i].size())
+                    return false;
+            }
+            return true;
+        }
+
+        //比较全部引擎在inputs上的结果,不一致时返回描述并设置failing为出错的输入下标
+        std::string checkSet(EngineSet &set, const std::vector<std::string> &inputs, size_t &failing) {
+            failing = 0;
+            if (set.states != set.threadedStates)
+                return "min-dfa-mt.stateCount";
+            std::vector<std::string_view> views(inputs.begin(), inputs.end());
+            std::vector<uint8_t> expected(views.size());
+            MatchBuffer buffer;
+            for (size_t i = 0; i < views.size(); i++) {
+                failing = i;
+                std::string_view view = views[i];
+                expected[i] = set.reference->match(view);
+                bool prefix = set.reference->matchPrefix(view);
+                std::vector<std::string_view> found = set.reference->contains(view);
+                buffer.clear();
+                set.reference->contains(view, buffer);
+                if (!samePositions(buffer, view, found))
+                    return "nfa.contains(MatchBuffer)";
+                bool anywhere = set.reference->isMatchAnywhere(view);
+                //存在匹配的前缀或contains找到匹配时必然存在匹配
+                if ((prefix || !found.empty()) && !anywhere)
+                    return "nfa.isMatchAnywhere";
+                if (set.reference->count(view) != found.size())
+                    return "nfa.count";
+                for (Engine &engine: set.engines) {
+                    Pattern &pattern = *engine.pattern;
+                    if (pattern.match(view) != (bool) expected[i])
+                        return engine.name + ".match";
+                    if (pattern.matchPrefix(view) != prefix)
+                        return engine.name + ".matchPrefix";
+                    if (!samePositions(pattern.contains(view), found))
+                        return engine.name + ".contains";
+                    buffer.clear();
+                    pattern.contains(view, buffer, 1);
+                    if (!samePositions(buffer, view, found))
+                        return engine.name + ".contains(MatchBuffer)";
+                    if (pattern.matchChunked(view, 3, 1) != (bool) expected[i])
+                        return engine.name + ".matchChunked";
+                    if (pattern.isMatchAnywhere(view) != anywhere)
+                        return engine.name + ".isMatchAnywhere";
+                    if (pattern.count(view) != found.size())
+                        return engine.name + ".count";
+                }
+            }
+            std::vector<uint8_t> out(views.size());
+            for (Engine &engine: set.engines) {
+                engine.pattern->matchBatch(views.data(), views.size(), out.data(), 4);
+                for (size_t i = 0; i < views.size(); i++) {
+                    if ((bool) out[i] != (bool) expected[i]) {
+                        failing = i;
+                        return engine.name + ".matchBatch";
+                    }
+                }
+            }
+            return "";
+        }
+    }  // namespace
+
+    DiffFuzzer::DiffFuzzer(const FuzzOptions &options) : options(options), rng(options.seed) {}
+
+    // alternation ::= sequence ("|" sequence)*,分支可以为空
+    std::string DiffFuzzer::alternation(int depth) {
+        std::string pattern;
+        size_t branches = 1 + below(3);
+        for (size_t i = 0; i < branches; i++) {
+            if (i > 0)
+                pattern += '|';
+            size_t atoms = below(4);
+            for (size_t j = 0; j < atoms; j++)
+                pattern += atom(depth);
+        }
+        return pattern;
+    }
+
+    //一个带可选闭包的term或factor
+    std::string DiffFuzzer::atom(int depth) {
+        static const char *const literals[] = {"a", "b", "c", "A", " ", "1", "_", "\xC3\xA9"};
+        static const char *const escapes[] = {"\\d", "\\D", "\\w", "\\W", "\\s", "\\S", "\\n", "\\x41",
+                                              "\\.", "\\*", "\\(", "\\[", "\\|", "\\\\"};
+        static const char *const looks[] = {"^", "$", "\\b", "\\B", "\\A", "\\z"};
+        static const char *const classItems[] = {"a", "b", "c", "a-c", "B-Z", "0-9", "\\d", "\\w", "\\s", " ", "_",
+                                                 "[:alpha:]", "[:^digit:]", "[b_]", "&&[^b]", "\\x61-\\x63"};
+        std::string term;
+        size_t kind = below(16);
+        if (kind < 6) {
+            term = literals[below(sizeof(literals) / sizeof(*literals))];
+        } else if (kind < 8) {
+            term = escapes[below(sizeof(escapes) / sizeof(*escapes))];
+        } else if (kind == 8) {
+            term = ".";
+        } else if (kind < 11) {
+            term = below(3) == 0 ? "[^" : "[";
+            size_t items = 1 + below(3);
+            for (size_t i = 0; i < items; i++)
+                term += classItems[below(sizeof(classItems) / sizeof(*classItems))];
+            term += ']';
+        } else if (kind < 13) {
+            //断言不加闭包
+            return looks[below(sizeof(looks) / sizeof(*looks))];
+        } else {
+            term = depth < options.maxDepth ? "(" + alternation(depth + 1) + ")" : "a";
+        }
+        switch (below(10)) {
+        case 0:
+            term += '*';
+            break;
+        case 1:
+            term += '+';
+            break;
+        case 2:
+            term += '?';
+            break;
+        case 3: {
+            size_t n = below(3);
+            size_t form = below(3);
+            if (form == 0)
+                term += "{" + std::to_string(n) + "}";
+            else if (form == 1)
+                term += "{" + std::to_string(n) + ",}";
+            else
+                term += "{" + std::to_string(n) + "," + std::to_string(n + below(3)) + "}";
+            break;
+        }
+        default:
+            break;
+        }
+        return term;
+    }
+
+    //随机pattern
+    std::string DiffFuzzer::randomPattern() {
+        return alternation(0);
+    }
+
+    //随机输入,由容易触发各类字符集与断言的片段组成
+    std::string DiffFuzzer::randomInput() {
+        static const char *const pieces[] = {"a", "b", "c", "A", "B", " ", "\t", "\n", "1", "_", ".", "*", "-", "\xC3\xA9"};
+        std::string input;
+        size_t length = below(options.maxInputLength + 1);
+        for (size_t i = 0; i < length; i++)
+            input += pieces[below(sizeof(pieces) / sizeof(*pieces))];
+        return input;
+    }
+
+    //随机flags
+    unsigned DiffFuzzer::randomFlags() {
+        unsigned flags = RegexFlags::none;
+        if (below(3) == 0)
+            flags |= RegexFlags::multiline;
+        if (below(6) == 0)
+            flags |= RegexFlags::utf8;
+        if (below(4) == 0)
+            flags |= RegexFlags::caseInsensitive;
+        return flags;
+    }
+
+    //检查一个pattern
+    std::string DiffFuzzer::check(const std::string &pattern, unsigned flags, const std::vector<std::string> &inputs,
+                                  const CompileLimits &limits) {
+        try {
+            EngineSet set = build(pattern, flags, limits);
+            size_t failing;
+            return checkSet(set, inputs, failing);
+        } catch (const RegexException &) {
+            throw;
+        } catch (const std::exception &e) {
+            return std::string("exception: ") + e.what();
+        }
+    }
+
+    //缩小用例:先以一半长度为步长删除连续片段,逐步减小到单个字符,input与pattern交替直到不再变化
+    FuzzFailure DiffFuzzer::minimize(const FuzzFailure &failure, const CompileLimits &limits) {
+        FuzzFailure best = failure;
+        auto fails = [&](const std::string &pattern, const std::string &input) {
+            try {
+                return !check(pattern, best.flags, {input}, limits).empty();
+            } catch (const RegexException &) {
+                //删除后pattern不再合法
+                return false;
+            }
+        };
+        if (!fails(best.pattern, best.input))
+            return best;
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (bool onInput: {true, false}) {
+                std::string &text = onInput ? best.input : best.pattern;
+                for (size_t width = std::max<size_t>(text.size() / 2, 1);; width /= 2) {
+                    for (size_t i = 0; i + width <= text.size();) {
+                        std::string candidate = text;
+                        candidate.erase(i, width);
+                        if (onInput ? fails(best.pattern, candidate) : fails(candidate, best.input)) {
+                            text = candidate;
+                            changed = true;
+                        } else {
+                            i++;
+                        }
+                    }
+                    if (width == 1)
+                        break;
+                }
+            }
+        }
+        best.detail = check(best.pattern, best.flags, {best.input}, limits);
+        return best;
+    }
+
+    //运行
+    FuzzReport DiffFuzzer::run() {
+        FuzzReport report;
+        std::vector<std::string> inputs(options.inputsPerPattern);
+        for (size_t iteration = 0; iteration < options.iterations; iteration++) {
+            std::string pattern = randomPattern();
+            unsigned flags = randomFlags();
+            for (std::string &input: inputs)
+                input = randomInput();
+            report.patterns++;
+            EngineSet set;
+            try {
+                set = build(pattern, flags, options.limits);
+            } catch (const RegexException &e) {
+                if (e.isLimit())
+                    report.pathologies.push_back(FuzzPathology{pattern, flags, 0, 0, e.what()});
+                else
+                    report.rejected++;
+                continue;
+            } catch (const std::exception &e) {
+                report.failures.push_back(FuzzFailure{pattern, flags, "", std::string("exception: ") + e.what()});
+                continue;
+            }
+            report.compileSeconds += set.seconds;
+            report.maxStates = std::max(report.maxStates, set.states);
+            if (set.seconds > options.slowCompileSeconds || set.states > options.maxStates)
+                report.pathologies.push_back(FuzzPathology{pattern, flags, set.seconds, set.states, ""});
+            report.inputs += inputs.size();
+            size_t failing;
+            std::string detail;
+            try {
+                detail = checkSet(set, inputs, failing);
+            } catch (const std::exception &e) {
+                failing = 0;
+                detail = std::string("exception: ") + e.what();
+            }
+            if (!detail.empty())
+                report.failures.push_back(minimize(FuzzFailure{pattern, flags, inputs[failing], detail},
+                                                   options.limits));
+        }
+        timeChain(report);
+        return report;
+    }
+
+    //字面量的每个前缀各为一个状态,没有可合并的状态,逐轮细分的最小化需要约chainLength轮
+    void DiffFuzzer::timeChain(FuzzReport &report) {
+        if (options.chainLength == 0)
+            return;
+        std::string pattern;
+        for (size_t i = 0; i < options.chainLength; i++)
+            pattern += (char) ('a' + i * 7 % 26);
+        std::string_view view = pattern;
+        auto begin = Clock::now();
+        try {
+            DFA machine(view, true, NFAConstruction::thompson, 1, RegexFlags::none, options.limits);
+            report.chainSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+            if (report.chainSeconds > options.slowChainSeconds)
+                report.pathologies.push_back(
+                        FuzzPathology{pattern, RegexFlags::none, report.chainSeconds, machine.stateCount(), ""});
+        } catch (const RegexException &e) {
+            report.chainSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+            report.pathologies.push_back(FuzzPathology{pattern, RegexFlags::none, report.chainSeconds, 0, e.what()});
+        }
+    }
+}  // namespace zhRegex
+
+#ifdef ZH_REGEX_LIBFUZZER
+// libFuzzer入口(clang++ -fsanitize=fuzzer -DZH_REGEX_LIBFUZZER,不链接main.cpp)
+//首字节的低3位为flags(utf8、multiline、caseInsensitive),之后到第一个\0为pattern,其余按\0分隔为输入;发现不一致时abort
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    using namespace zhRegex;
+    if (size == 0)
+        return 0;
+    unsigned flags = data[0] & (RegexFlags::utf8 | RegexFlags::multiline | RegexFlags::caseInsensitive);
+    std::string text(reinterpret_cast<const char *>(data) + 1, size - 1);
+    size_t end = text.find('\0');
+    std::string pattern = text.substr(0, end);
+    std::vector<std::string> inputs;
+    while (end != std::string::npos) {
+        size_t next = text.find('\0', end + 1);
+        inputs.push_back(text.substr(end + 1, next == std::string::npos ? std::string::npos : next - end - 1));
+        end = next;
+    }
+    CompileLimits limits;
+    limits.maxNFANodes = 1 << 14;
+    limits.maxDFAStates = 1 << 12;
+    limits.maxTime = std::chrono::milliseconds(1000);
+    try {
+        if (!DiffFuzzer::check(pattern, flags, inputs, limits).empty())
+            std::abort();
+    } catch (const RegexException &) {
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,106 @@
+#ifndef _ZH_DIFF_FUZZ_H_
+#define _ZH_DIFF_FUZZ_H_
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CompileLimits.h"
+
+namespace zhRegex {
+    //差分测试的参数
+    struct FuzzOptions {
+        uint64_t seed = 1;
+        //生成的pattern个数
+        size_t iterations = 1000;
+        //每个pattern的随机输入个数
+        size_t inputsPerPattern = 32;
+        //括号的最大嵌套层数
+        int maxDepth = 3;
+        //随机输入的最大长度(按片段计,一个片段可能是多字节的UTF-8字符)
+        size_t maxInputLength = 16;
+        //构造全部引擎的耗时(秒)或最小DFA的状态数超过阈值时记为性能异常
+        double slowCompileSeconds = 0.5;
+        int maxStates = 2000;
+        //计时用例:chainLength个字节的字面量编译为最小DFA(链状DFA,最小化的最坏情况),耗时超过阈值时记为性能异常
+        size_t chainLength = 20000;
+        double slowChainSeconds = 2.0;
+        //编译限制,超出时该pattern记为性能异常并跳过
+        CompileLimits limits;
+    };
+
+    //一个不一致的用例,pattern与input已尽量缩小
+    struct FuzzFailure {
+        std::string pattern;
+        unsigned flags;
+        std::string input;
+        //不一致的引擎与操作
+        std::string detail;
+    };
+
+    //构造耗时或状态数异常的pattern
+    struct FuzzPathology {
+        std::string pattern;
+        unsigned flags;
+        double seconds;
+        int states;
+        //为空表示超过阈值,否则为超出编译限制时的错误信息
+        std::string limit;
+    };
+
+    struct FuzzReport {
+        size_t patterns = 0;
+        //生成的pattern中无法解析的个数(生成器的质量指标)
+        size_t rejected = 0;
+        size_t inputs = 0;
+        double compileSeconds = 0;
+        int maxStates = 0;
+        //长字面量的编译耗时
+        double chainSeconds = 0;
+        std::vector<FuzzFailure> failures;
+        std::vector<FuzzPathology> pathologies;
+    };
+
+    //多引擎差分测试:随机生成合法语法内的pattern(连接、或、闭包、{n,m}、字符集、转义、断言)与输入,
+    //以未经ASTOptimizer化简的NFA模拟为基准,比较化简后的NFA、未最小化DFA、最小DFA(单线程与多线程)、
+    //Glushkov构造的DFA、PositionNFA的
+    //match/matchPrefix/contains/isMatchAnywhere/count,以及MatchBuffer、matchBatch、matchChunked等路径,不一致时缩小用例
+    class DiffFuzzer {
+    private:
+        FuzzOptions options;
+        std::mt19937_64 rng;
+
+        size_t below(size_t n) {
+            return (size_t) (rng() % n);
+        }
+
+        std::string alternation(int depth);
+        std::string atom(int depth);
+
+    public:
+        explicit DiffFuzzer(const FuzzOptions &options = FuzzOptions());
+
+        //随机pattern与输入
+        std::string randomPattern();
+        std::string randomInput();
+        //随机flags(多行、UTF-8、忽略大小写)
+        unsigned randomFlags();
+
+        //用全部引擎检查pattern在inputs上的结果,返回第一处不一致的描述,一致时返回空串
+        //pattern无法解析时抛出RegexException
+        static std::string check(const std::string &pattern, unsigned flags, const std::vector<std::string> &inputs,
+                                 const CompileLimits &limits = CompileLimits());
+
+        //逐步删除pattern与input中的字符,保留仍然不一致的最小用例
+        static FuzzFailure minimize(const FuzzFailure &failure, const CompileLimits &limits = CompileLimits());
+
+        //编译长字面量并计时,超过阈值或超出编译限制时记入report.pathologies
+        void timeChain(FuzzReport &report);
+
+        //运行options.iterations轮,最后运行timeChain
+        FuzzReport run();
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_DIFF_FUZZ_H_
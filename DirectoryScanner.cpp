@@ -0,0 +1,298 @@
+#include "DirectoryScanner.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+namespace zhRegex {
+    namespace {
+        //任务中的一段:整个小文件,或大文件中行首位于[begin, end)的行
+        struct Piece {
+            size_t file;
+            size_t begin;
+            size_t end;
+            bool whole;
+            //是否为文件的最后一段
+            bool last;
+        };
+
+        //一个匹配的行,文本存放在PieceResult::text中
+        struct Hit {
+            size_t lineNumber;
+            size_t offset;
+            size_t textBegin;
+            size_t textLength;
+        };
+
+        //一段的结果,行号与偏移相对于这一段
+        struct PieceResult {
+            bool error = false;
+            //段首在文件中的偏移
+            size_t offset = 0;
+            size_t newlines = 0;
+            std::string text;
+            std::vector<Hit> hits;
+        };
+
+        struct Task {
+            std::vector<Piece> pieces;
+            std::vector<PieceResult> results;
+            bool done = false;
+        };
+
+        //每个线程一个任务队列:自己从队首取,窃取时从其他队列的队尾取
+        //队首是编号最小的任务,先完成它们可以让调用线程尽早输出
+        class TaskQueue {
+        private:
+            std::mutex mutex;
+            std::deque<size_t> tasks;
+
+        public:
+            void push(size_t task) {
+                tasks.push_back(task);
+            }
+
+            bool popFront(size_t &task) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (tasks.empty())
+                    return false;
+                task = tasks.front();
+                tasks.pop_front();
+                return true;
+            }
+
+            bool stealBack(size_t &task) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (tasks.empty())
+                    return false;
+                task = tasks.back();
+                tasks.pop_back();
+                return true;
+            }
+        };
+
+        //从offset处读取最多size字节追加到buffer,返回读到的字节数,出错时返回-1
+        long readAt(int fd, std::string &buffer, size_t offset, size_t size) {
+            size_t old = buffer.size();
+            buffer.resize(old + size);
+            size_t total = 0;
+            while (total < size) {
+                ssize_t n = ::pread(fd, &buffer[old + total], size - total, (off_t) (offset + total));
+                if (n < 0) {
+                    buffer.resize(old);
+                    return -1;
+                }
+                if (n == 0)
+                    break;
+                total += (size_t) n;
+            }
+            buffer.resize(old + total);
+            return (long) total;
+        }
+
+        //读取一段中完整的行:[begin, end)之前未结束的行属于上一段,从end开始的行的剩余部分属于这一段
+        //data为读到的内容,返回这一段的行在data中的起点,出错时返回npos
+        size_t readPiece(int fd, const Piece &piece, std::string &data, size_t &base) {
+            const size_t step = 1 << 16;
+            if (piece.whole) {
+                base = 0;
+                for (long n; (n = readAt(fd, data, data.size(), step)) != 0;) {
+                    if (n < 0)
+                        return std::string::npos;
+                }
+                return 0;
+            }
+            //多读前一个字节以判断begin是否为行首
+            base = piece.begin > 0 ? piece.begin - 1 : 0;
+            if (readAt(fd, data, base, piece.end - base) < 0)
+                return std::string::npos;
+            size_t start = 0;
+            if (piece.begin > 0) {
+                size_t newline = data.find('\n');
+                if (newline == std::string::npos)
+                    return data.size();
+                start = newline + 1;
+            }
+            if (piece.last) {
+                for (long n; (n = readAt(fd, data, base + data.size(), step)) != 0;) {
+                    if (n < 0)
+                        return std::string::npos;
+                }
+            } else {
+                while (!data.empty() && data.back() != '\n') {
+                    size_t before = data.size();
+                    long n = readAt(fd, data, base + before, step);
+                    if (n < 0)
+                        return std::string::npos;
+                    if (n == 0)
+                        break;
+                    size_t newline = data.find('\n', before);
+                    if (newline != std::string::npos)
+                        data.resize(newline + 1);
+                }
+            }
+            return start;
+        }
+    }  // namespace
+
+    DirectoryScanner::DirectoryScanner(const LineSearcher &searcher, const DirectoryScanOptions &options)
+            : searcher(searcher), options(options) {
+        this->options.threads = std::max(this->options.threads, 1u);
+        this->options.batchFiles = std::max<size_t>(this->options.batchFiles, 1);
+        this->options.chunkBytes = std::max<size_t>(this->options.chunkBytes, 1);
+    }
+
+    //列出roots下的文件
+    std::vector<std::string> DirectoryScanner::listFiles(const std::vector<std::string> &roots) {
+        namespace fs = std::filesystem;
+        std::vector<std::string> files;
+        for (const std::string &root: roots) {
+            std::error_code error;
+            if (!fs::is_directory(root, error)) {
+                files.push_back(root);
+                continue;
+            }
+            std::vector<std::string> found;
+            fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, error), end;
+            for (; !error && it != end; it.increment(error)) {
+                if (it->is_regular_file(error))
+                    found.push_back(it->path().string());
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        }
+        return files;
+    }
+
+    //扫描files
+    size_t DirectoryScanner::scan(const std::vector<std::string> &files, const ScanCallbacks &callbacks) {
+        //划分任务
+        std::vector<Task> tasks;
+        Task batch;
+        size_t batchBytes = 0;
+        auto flush = [&]() {
+            if (!batch.pieces.empty())
+                tasks.push_back(std::move(batch));
+            batch = Task();
+            batchBytes = 0;
+        };
+        for (size_t file = 0; file < files.size(); file++) {
+            std::error_code error;
+            size_t size = (size_t) std::filesystem::file_size(files[file], error);
+            if (error || size <= options.chunkBytes) {
+                batch.pieces.push_back(Piece{file, 0, 0, true, true});
+                batchBytes += error ? 0 : size;
+                if (batchBytes >= options.batchBytes || batch.pieces.size() >= options.batchFiles)
+                    flush();
+                continue;
+            }
+            flush();
+            for (size_t begin = 0; begin < size; begin += options.chunkBytes) {
+                size_t end = std::min(size, begin + options.chunkBytes);
+                Task chunk;
+                chunk.pieces.push_back(Piece{file, begin, end, false, end == size});
+                tasks.push_back(std::move(chunk));
+            }
+        }
+        flush();
+
+        std::mutex doneMutex;
+        std::condition_variable doneReady;
+        auto run = [&](Task &task) {
+            task.results.resize(task.pieces.size());
+            for (size_t i = 0; i < task.pieces.size(); i++) {
+                const Piece &piece = task.pieces[i];
+                PieceResult &result = task.results[i];
+                int fd = ::open(files[piece.file].c_str(), O_RDONLY);
+                std::string data;
+                size_t base = 0;
+                size_t start = fd < 0 ? std::string::npos : readPiece(fd, piece, data, base);
+                if (fd >= 0)
+                    ::close(fd);
+                if (start == std::string::npos) {
+                    result.error = true;
+                    continue;
+                }
+                std::string_view input(data.data() + start, data.size() - start);
+                result.offset = base + start;
+                result.newlines = (size_t) std::count(input.begin(), input.end(), '\n');
+                searcher.forEachLine(input, options.invert, [&result](const LineMatch &line) {
+                    result.hits.push_back(Hit{line.lineNumber, line.offset, result.text.size(), line.text.size()});
+                    result.text.append(line.text.data(), line.text.size());
+                });
+            }
+            std::lock_guard<std::mutex> lock(doneMutex);
+            task.done = true;
+            doneReady.notify_all();
+        };
+
+        //任务轮流分给各线程,编号小的任务分散在每个队列的队首
+        unsigned threads = (unsigned) std::min<size_t>(options.threads, std::max<size_t>(tasks.size(), 1));
+        std::vector<TaskQueue> queues(threads);
+        for (size_t i = 0; i < tasks.size(); i++)
+            queues[i % threads].push(i);
+        std::vector<std::thread> workers;
+        for (unsigned worker = 0; worker < threads; worker++) {
+            workers.emplace_back([&, worker]() {
+                size_t task;
+                for (;;) {
+                    bool found = queues[worker].popFront(task);
+                    for (unsigned k = 1; !found && k < threads; k++)
+                        found = queues[(worker + k) % threads].stealBack(task);
+                    //任务不会再增加,所有队列都为空时结束
+                    if (!found)
+                        break;
+                    run(tasks[task]);
+                }
+            });
+        }
+
+        //按任务顺序输出
+        size_t matchedTotal = 0;
+        size_t lineBase = 0, matched = 0;
+        bool failed = false;
+        for (Task &task: tasks) {
+            {
+                std::unique_lock<std::mutex> lock(doneMutex);
+                doneReady.wait(lock, [&task]() { return task.done; });
+            }
+            for (size_t i = 0; i < task.pieces.size(); i++) {
+                const Piece &piece = task.pieces[i];
+                const PieceResult &result = task.results[i];
+                if (result.error && !failed) {
+                    failed = true;
+                    if (callbacks.onError)
+                        callbacks.onError(piece.file);
+                }
+                if (!failed) {
+                    for (const Hit &hit: result.hits) {
+                        if (callbacks.onLine)
+                            callbacks.onLine(ScanLine{piece.file, lineBase + hit.lineNumber, result.offset + hit.offset,
+                                                      std::string_view(result.text).substr(hit.textBegin,
+                                                                                           hit.textLength)});
+                    }
+                    lineBase += result.newlines;
+                    matched += result.hits.size();
+                }
+                if (piece.last) {
+                    if (!failed && callbacks.onFileEnd)
+                        callbacks.onFileEnd(piece.file, matched);
+                    matchedTotal += matched;
+                    lineBase = matched = 0;
+                    failed = false;
+                }
+            }
+            //输出后释放结果
+            task.results = std::vector<PieceResult>();
+        }
+        for (std::thread &worker: workers)
+            worker.join();
+        return matchedTotal;
+    }
+}  // namespace zhRegex
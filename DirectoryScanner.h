@@ -0,0 +1,43 @@
+#ifndef _ZH_DIRECTORY_SCANNER_H_
+#define _ZH_DIRECTORY_SCANNER_H_
+
+#include <string>
+#include <vector>
+
+#include "ScanPipeline.h"
+
+namespace zhRegex {
+    //目录扫描的参数
+    struct DirectoryScanOptions {
+        //工作线程数
+        unsigned threads = 1;
+        //小文件合并为一个任务,直到任务的字节数达到batchBytes或文件数达到batchFiles
+        size_t batchBytes = 1 << 20;
+        size_t batchFiles = 64;
+        //超过chunkBytes的文件按chunkBytes切分为多个任务
+        size_t chunkBytes = 8 << 20;
+        //输出不匹配的行
+        bool invert = false;
+    };
+
+    //大量文件的按行查找:文件先划分为任务(小文件成批,大文件分块),由工作窃取的线程池执行,
+    //所有线程共享同一个只读的LineSearcher;每个任务的结果只由执行它的线程写入自己的缓冲区,
+    //调用线程按任务顺序取出结果交给回调,因此输出顺序与线程数无关
+    class DirectoryScanner {
+    private:
+        const LineSearcher &searcher;
+        DirectoryScanOptions options;
+
+    public:
+        DirectoryScanner(const LineSearcher &searcher, const DirectoryScanOptions &options = DirectoryScanOptions());
+
+        //roots中的文件,以及目录下递归找到的全部普通文件(每个目录内按路径排序,不跟随目录的符号链接)
+        //无法访问的子目录被跳过
+        static std::vector<std::string> listFiles(const std::vector<std::string> &roots);
+
+        //扫描files,回调在调用scan的线程中按files的顺序、行顺序依次调用,返回匹配的总行数
+        size_t scan(const std::vector<std::string> &files, const ScanCallbacks &callbacks);
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_DIRECTORY_SCANNER_H_
@@ -6,6 +6,8 @@ namespace zhRegex {
 
     //获取下一个token
     void Lexer::advance() {
+        escaped = false;
+        hexEscape = false;
         if (index >= pattern.size()) {
             currentToken = RegExToken::Eof;
             currentChar = '\0';
@@ -14,6 +16,7 @@ namespace zhRegex {
         currentChar = pattern[index++];
         //如果跟着转义字符则调用escapeHandler(),否则调用semanticHandler()
         if (currentChar == '\\') {
+            escaped = true;
             currentToken = escapeHandler();
         } else {
             currentToken = semanticHandler();
@@ -22,28 +25,70 @@ namespace zhRegex {
 
     //处理转义字符
     RegExToken Lexer::escapeHandler() {
-        //部分转义字符
-        static char escapeCharacter[] = {
-            'd',  //代表数字
-            'D',  //代表非数字
-            'w',  //代表字符
-            'W'   //代表非字符
-        };
+        //模式以单个反斜杠结尾
+        if (index >= pattern.size()) {
+            throw RegexException();
+        }
         currentChar = pattern[index++];
-        for (char c : escapeCharacter) {
-            if (c == currentChar) {
-                return RegExToken::EscapeChar;
-            }
+        switch (currentChar) {
+        case 'd':  //代表数字
+        case 'D':  //代表非数字
+        case 'w':  //代表字符
+        case 'W':  //代表非字符
+        case 's':  //代表空白字符
+        case 'S':  //代表非空白字符
+            return RegExToken::EscapeChar;
+        case 'n':
+            currentChar = '\n';
+            return RegExToken::SingleChar;
+        case 't':
+            currentChar = '\t';
+            return RegExToken::SingleChar;
+        case 'r':
+            currentChar = '\r';
+            return RegExToken::SingleChar;
+        case 'f':
+            currentChar = '\f';
+            return RegExToken::SingleChar;
+        case 'v':
+            currentChar = '\v';
+            return RegExToken::SingleChar;
+        case 'x': {
+            //恰好两位十六进制数
+            int high = hexDigit();
+            int low = hexDigit();
+            currentChar = (char) (high << 4 | low);
+            hexEscape = true;
+            return RegExToken::SingleChar;
+        }
+        case 'b':
+            return RegExToken::WordBoundary;
+        case 'B':
+            return RegExToken::NotWordBoundary;
+        case 'A':
+            return RegExToken::TextBegin;
+        case 'z':
+            return RegExToken::TextEnd;
+        default:
+            return RegExToken::SingleChar;
         }
-        return RegExToken::SingleChar;
     }
 
     //处理普通字符
     RegExToken Lexer::semanticHandler() const {
-        if (regexTokens.find(currentChar) == regexTokens.end()) {
-            return RegExToken::SingleChar;
-        }
         return regexTokens[currentChar];
     }
 
-}  // namespace zhRegex
\ No newline at end of file
+    //读取\xHH的一位十六进制数
+    int Lexer::hexDigit() {
+        if (index >= pattern.size())
+            throw RegexException();
+        char c = pattern[index++];
+        if ('0' <= c && c <= '9')
+            return c - '0';
+        if ('a' <= (c | 0x20) && (c | 0x20) <= 'f')
+            return (c | 0x20) - 'a' + 10;
+        throw RegexException();
+    }
+
+}  // namespace zhRegex
\ No newline at end of file
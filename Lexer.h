@@ -9,9 +9,13 @@ namespace zhRegex {
     class Lexer {
     private:
         std::string_view pattern;
-        int index = 0;
+        size_t index = 0;
         RegExToken currentToken = RegExToken::Eof;
         char currentChar = '\0';
+        //当前token是否由反斜杠转义得到
+        bool escaped = false;
+        //当前字符是否由\xHH给出,UTF-8模式下表示码点U+00HH
+        bool hexEscape = false;
 
         //处理转义字符
         RegExToken escapeHandler();
@@ -19,6 +23,9 @@ namespace zhRegex {
         //处理普通字符
         RegExToken semanticHandler() const;
 
+        //读取\xHH的一位十六进制数
+        int hexDigit();
+
     public:
         Lexer() = default;
 
@@ -41,7 +48,27 @@ namespace zhRegex {
         inline char getCurrentChar() const {
             return currentChar;
         }
+
+        //当前token是否由转义得到,如\&不参与字符集的&&运算
+        inline bool isEscaped() const {
+            return escaped;
+        }
+
+        //当前字符是否由\xHH给出
+        inline bool isHexEscape() const {
+            return hexEscape;
+        }
+
+        //下一个尚未读取的字符,已到结尾时为'\0'
+        inline char peek() const {
+            return index < pattern.size() ? pattern[index] : '\0';
+        }
+
+        //当前读取到的位置
+        inline size_t getIndex() const {
+            return index;
+        }
     };
 }  // namespace zhRegex
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "LineSearcher.h"
+
+namespace zhRegex {
+    namespace {
+        //由pattern构造[^\n]*(pattern)的NFA
+        NFA unanchoredLineNFA(std::string_view pattern, unsigned flags, const CompileBudget *budget) {
+            Parser parser(pattern, flags);
+            RegexAST ast = parser.parse();
+            int anyInLine = ast.addNode(ASTNodeType::charCollection);
+            ast[anyInLine].charSet = std::make_shared<const CharSet>(~CharSet::of('\n'));
+            int prefix = ast.addNode(ASTNodeType::repeat);
+            ast[prefix].min = 0;
+            ast[prefix].max = -1;
+            ast[prefix].children.push_back(anyInLine);
+            int group = ast.addNode(ASTNodeType::group);
+            ast[group].children.push_back(ast.root);
+            int root = ast.addNode(ASTNodeType::concat);
+            ast[root].children = {prefix, group};
+            ast.root = root;
+            ASTOptimizer::optimize(ast);
+            return NFA(ast, budget);
+        }
+    }  // namespace
+
+    LineSearcher::LineSearcher(std::string_view pattern, unsigned flags, unsigned threads,
+                               const CompileLimits &limits) {
+        CompileBudget budget(limits);
+        NFA machine = unanchoredLineNFA(pattern, flags, &budget);
+        dfa = DFA(machine, true, threads, limits);
+        int states = dfa.stateCount();
+        skippable.assign(states, false);
+        for (int status = 0; status < states; status++) {
+            DFAAccel::Kind kind = dfa.accel[status].kind;
+            if (kind != DFAAccel::Kind::escapeBytes && kind != DFAAccel::Kind::loopRange)
+                continue;
+            bool accepting = dfa.statusMap[status];
+            for (int b = 0; b < 256; b++)
+                accepting = accepting || dfa.acceptBefore(status, (char) b);
+            skippable[status] = !accepting && dfa.transitions.next(status, '\n') < 0;
+        }
+    }
+
+    //全部匹配的行
+    std::vector<LineMatch> LineSearcher::search(std::string_view input, bool invert) const {
+        std::vector<LineMatch> lines;
+        forEachLine(input, invert, [&lines](const LineMatch &line) {
+            lines.push_back(line);
+        });
+        return lines;
+    }
+
+    //匹配的行数
+    size_t LineSearcher::count(std::string_view input, bool invert) const {
+        return forEachLine(input, invert, [](const LineMatch &) {});
+    }
+}  // namespace zhRegex
@@ -0,0 +1,110 @@
+#ifndef _ZH_LINE_SEARCHER_H_
+#define _ZH_LINE_SEARCHER_H_
+
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "DFA.h"
+
+namespace zhRegex {
+    //一个匹配的行
+    struct LineMatch {
+        //行号,从1开始
+        size_t lineNumber;
+        //行首在输入中的偏移
+        size_t offset;
+        //行内容,不含\n
+        std::string_view text;
+    };
+
+    //按行查找(grep):某一行中存在匹配pattern的子串时该行匹配,^和$匹配行首与行尾
+    //内部编译[^\n]*(pattern)的DFA,在整个输入上只走一遍,不预先切分行:
+    //  遇到\n时按行尾判断是否匹配并回到起始点;
+    //  一旦命中(或进入死状态)该行已有结论,用memchr直接跳到下一个\n;
+    //  其余时间在不经过\n的自环上借助加速态跳过
+    class LineSearcher {
+    private:
+        DFA dfa;
+        //可以直接跳过自环的状态:加速态,自环不含\n,且在自环上不会命中
+        std::vector<bool> skippable;
+
+    public:
+        explicit LineSearcher(std::string_view pattern, unsigned flags = RegexFlags::none, unsigned threads = 1,
+                              const CompileLimits &limits = CompileLimits());
+
+        //依次对每个匹配(invert为true时为不匹配)的行调用visit(const LineMatch &),返回这样的行数
+        //以\n结尾的输入最后没有空行
+        template <typename Visit>
+        size_t forEachLine(std::string_view input, bool invert, Visit &&visit) const;
+
+        //全部匹配(invert为true时为不匹配)的行
+        std::vector<LineMatch> search(std::string_view input, bool invert = false) const;
+        //匹配(invert为true时为不匹配)的行数
+        size_t count(std::string_view input, bool invert = false) const;
+
+        //DFA状态个数
+        inline int stateCount() const {
+            return dfa.stateCount();
+        }
+    };
+
+    template <typename Visit>
+    size_t LineSearcher::forEachLine(std::string_view input, bool invert, Visit &&visit) const {
+        const char *begin = input.data();
+        const char *end = begin + input.size();
+        const char *lineBegin = begin;
+        size_t lineNumber = 1;
+        size_t count = 0;
+        while (lineBegin < end) {
+            int status = dfa.startNode;
+            const char *p = lineBegin;
+            //是否已有结论(命中或不可能命中)
+            bool decided = false;
+            bool hit = false;
+            while (p < end && *p != '\n') {
+                if (dfa.accel[status].kind != DFAAccel::Kind::none) {
+                    if (dfa.accel[status].kind == DFAAccel::Kind::dead) {
+                        decided = true;
+                        break;
+                    }
+                    if (dfa.accel[status].kind == DFAAccel::Kind::universal) {
+                        decided = hit = true;
+                        break;
+                    }
+                    if (skippable[status]) {
+                        p = dfa.skipLoop(status, p, end);
+                        if (p == end || *p == '\n')
+                            break;
+                    }
+                }
+                if (dfa.acceptBefore(status, *p)) {
+                    decided = hit = true;
+                    break;
+                }
+                status = dfa.transitions.next(status, *p++);
+                if (status < 0) {
+                    decided = true;
+                    break;
+                }
+            }
+            if (!decided)
+                hit = dfa.statusMap[status];
+            else
+                p = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            const char *lineEnd = p == nullptr ? end : p;
+            if (hit != invert) {
+                count++;
+                visit(LineMatch{lineNumber, (size_t) (lineBegin - begin),
+                                std::string_view(lineBegin, lineEnd - lineBegin)});
+            }
+            if (lineEnd == end)
+                break;
+            lineBegin = lineEnd + 1;
+            lineNumber++;
+        }
+        return count;
+    }
+}  // namespace zhRegex
+
+#endif  // !_ZH_LINE_SEARCHER_H_
@@ -0,0 +1,60 @@
+#ifndef _ZH_LOOK_H_
+#define _ZH_LOOK_H_
+
+#include <array>
+#include <cstdint>
+
+namespace zhRegex {
+    //每个字节一位的位图
+    using ByteBitmap = std::array<uint64_t, 4>;
+
+    //零宽断言,可按位组合表示某个位置满足的全部断言
+    //一个位置满足哪些断言只取决于其前一个字节的种类(Context)与后一个字节
+    struct Look {
+        static constexpr uint8_t textBegin = 1u << 0;        // ^,\A
+        static constexpr uint8_t textEnd = 1u << 1;          // $,\z
+        static constexpr uint8_t lineBegin = 1u << 2;        //多行模式下的^
+        static constexpr uint8_t lineEnd = 1u << 3;          //多行模式下的$
+        static constexpr uint8_t wordBoundary = 1u << 4;     // \b
+        static constexpr uint8_t notWordBoundary = 1u << 5;  // \B
+
+        //前一个字节的种类
+        enum Context : uint8_t {
+            atTextBegin,   //位于文本开头
+            afterNewline,  //前一个字节为\n
+            afterWord,     //前一个字节为单词字符
+            afterOther     //其他字节之后
+        };
+        static constexpr int contextCount = 4;
+
+        //单词字符,即[0-9A-Za-z_]
+        static inline bool isWordByte(char c) {
+            return ('0' <= c && c <= '9') || ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_';
+        }
+
+        //字节c之后的位置的种类
+        static inline Context contextOf(char c) {
+            if (c == '\n')
+                return afterNewline;
+            return isWordByte(c) ? afterWord : afterOther;
+        }
+
+        //前一个字节的种类为context、后一个字节为next(-1表示文本结尾)时,该位置满足的全部断言
+        static inline uint8_t satisfied(Context context, int next) {
+            uint8_t looks = 0;
+            if (context == atTextBegin)
+                looks |= textBegin | lineBegin;
+            else if (context == afterNewline)
+                looks |= lineBegin;
+            if (next < 0)
+                looks |= textEnd | lineEnd;
+            else if ((char) next == '\n')
+                looks |= lineEnd;
+            bool nextWord = next >= 0 && isWordByte((char) next);
+            looks |= (context == afterWord) != nextWord ? wordBoundary : notWordBoundary;
+            return looks;
+        }
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_LOOK_H_
@@ -0,0 +1,102 @@
+#ifndef _ZH_MATCH_BUFFER_H_
+#define _ZH_MATCH_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace zhRegex {
+    //可复用的匹配结果缓冲区,由调用者在多次contains之间保留
+    //每条记录为(偏移, 长度, pattern编号),按字段分别连续存放(SoA);
+    //容量不足时按两倍增长,clear只把个数置0,之后的调用不再分配内存
+    class MatchBuffer {
+    private:
+        std::vector<size_t> offsets;
+        std::vector<size_t> lengths;
+        std::vector<uint32_t> patterns;
+        size_t count = 0;
+
+        void grow(size_t capacity) {
+            offsets.resize(capacity);
+            lengths.resize(capacity);
+            patterns.resize(capacity);
+        }
+
+    public:
+        MatchBuffer() = default;
+
+        explicit MatchBuffer(size_t capacity) {
+            grow(capacity);
+        }
+
+        //清空记录,保留容量
+        inline void clear() {
+            count = 0;
+        }
+
+        inline void reserve(size_t capacity) {
+            if (capacity > offsets.size())
+                grow(capacity);
+        }
+
+        inline void push(size_t offset, size_t length, uint32_t pattern = 0) {
+            if (count == offsets.size())
+                grow(count < 8 ? 8 : count * 2);
+            offsets[count] = offset;
+            lengths[count] = length;
+            patterns[count] = pattern;
+            count++;
+        }
+
+        inline size_t size() const {
+            return count;
+        }
+
+        inline bool empty() const {
+            return count == 0;
+        }
+
+        inline size_t capacity() const {
+            return offsets.size();
+        }
+
+        inline size_t offset(size_t i) const {
+            return offsets[i];
+        }
+
+        inline size_t length(size_t i) const {
+            return lengths[i];
+        }
+
+        inline uint32_t pattern(size_t i) const {
+            return patterns[i];
+        }
+
+        //各字段的连续数组,长度为size()
+        inline const size_t *offsetData() const {
+            return offsets.data();
+        }
+
+        inline const size_t *lengthData() const {
+            return lengths.data();
+        }
+
+        inline const uint32_t *patternData() const {
+            return patterns.data();
+        }
+
+        //第i条记录在input中对应的string
+        inline std::string_view view(std::string_view input, size_t i) const {
+            return input.substr(offsets[i], lengths[i]);
+        }
+
+        //占用的内存字节数
+        inline size_t memoryUsage() const {
+            return offsets.capacity() * sizeof(size_t) + lengths.capacity() * sizeof(size_t)
+                   + patterns.capacity() * sizeof(uint32_t);
+        }
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_MATCH_BUFFER_H_
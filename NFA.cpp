@@ -1,301 +1,189 @@
 #include "NFA.h"
 
 #include "DFA.h"
+#include "SubsetBuilder.h"
 
 namespace zhRegex {
-    // class NFANode
-    NFANode::NFANode() {
-        edgeValue = '\0';
-        edgeType = NFAEdgeType::eofEdge;
-        edgeSet = nullptr;
-    }
+    namespace {
+        // forEachMatch的临时空间,每个线程一份,在多次调用之间复用,容量稳定后不再分配内存
+        //marks按用过的最大NFA的节点数增长,stamp回绕时清零marks
+        struct MatchScratch {
+            std::vector<uint32_t> marks;
+            uint32_t stamp = 0;
+            std::vector<uint32_t> start, current, next;
+
+            inline uint32_t nextStamp() {
+                if (++stamp == 0) {
+                    std::fill(marks.begin(), marks.end(), 0);
+                    stamp = 1;
+                }
+                return stamp;
+            }
+        };
+
+        MatchScratch &matchScratch(size_t nodeCount) {
+            thread_local MatchScratch scratch;
+            if (scratch.marks.size() < nodeCount)
+                scratch.marks.resize(nodeCount, 0);
+            return scratch;
+        }
+    }  // namespace
 
+    // class NFANode
     NFANode::NFANode(NFAEdgeType edgeType) {
-        this->edgeValue = '\0';
         this->edgeType = edgeType;
-        this->edgeSet = nullptr;
-        if (edgeType == NFAEdgeType::charCollection)
-            edgeSet = std::make_shared<hashSet<char>>();
     }
 
-    NFANode::NFANode(const NFANode &node) {
-        edgeValue = node.edgeValue;
-        edgeType = node.edgeType;
-        edgeSet = nullptr;
-        if (node.edgeSet != nullptr) {
-            edgeSet = std::make_shared<hashSet<char>>(*node.edgeSet);
-        }
-        if (node.next1 != nullptr) {
-            next1 = node.next1;
-        }
-        if (node.next2 != nullptr) {
-            next2 = node.next2;
-        }
-        if (node.loop.lock() != nullptr) {
-            loop = node.loop;
-        }
+    // class NFA
+    NFA::NFA(const char *pattern, unsigned flags, const CompileLimits &limits) {
+        ZH_STATS_COMPILE_BEGIN();
+        CompileBudget budget(limits);
+        std::string_view patternS = pattern;
+        Parser parser(patternS, flags);
+        RegexAST ast = parser.parse();
+        ASTOptimizer::optimize(ast);
+        build(ast, &budget);
+        ZH_STATS_COMPILE_END(pattern, "nfa", nodeCount());
     }
 
-    void NFANode::inverseCharSet() {
-        if (edgeSet == nullptr)
-            return;
-        hashSet<char> originSet;
-        originSet.swap(*edgeSet);
-        for (int c = CHAR_MIN; c < CHAR_MAX; ++c) {
-            if (originSet.find(c) == originSet.end())
-                edgeSet->emplace(c);
-        }
+    NFA::NFA(std::string &pattern, unsigned flags, const CompileLimits &limits) {
+        ZH_STATS_COMPILE_BEGIN();
+        CompileBudget budget(limits);
+        std::string_view patternS = pattern;
+        Parser parser(patternS, flags);
+        RegexAST ast = parser.parse();
+        ASTOptimizer::optimize(ast);
+        build(ast, &budget);
+        ZH_STATS_COMPILE_END(pattern, "nfa", nodeCount());
     }
 
-    // class NFA
-    NFA::NFA(const char *pattern) {
-        std::string_view patternS = pattern;
-        this->lexer = Lexer(patternS);
-        NFANodePair pair;
-        lexer.advance();
-        regexExpression(pair);
-        this->head = pair.start;
+    NFA::NFA(std::string_view &pattern, unsigned flags, const CompileLimits &limits) {
+        ZH_STATS_COMPILE_BEGIN();
+        CompileBudget budget(limits);
+        Parser parser(pattern, flags);
+        RegexAST ast = parser.parse();
+        ASTOptimizer::optimize(ast);
+        build(ast, &budget);
+        ZH_STATS_COMPILE_END(pattern, "nfa", nodeCount());
     }
 
-    NFA::NFA(std::string &pattern) {
-        std::string_view patternS = pattern;
-        this->lexer = Lexer(patternS);
-        NFANodePair pair;
-        lexer.advance();
-        regexExpression(pair);
-        this->head = pair.start;
+    //由AST直接构造,不做化简
+    NFA::NFA(const RegexAST &ast, const CompileBudget *budget) {
+        build(ast, budget);
     }
 
-    NFA::NFA(std::string_view &pattern) {
-        this->lexer = Lexer(pattern);
-        NFANodePair pair;
-        lexer.advance();
-        regexExpression(pair);
-        this->head = pair.start;
+    //新建一个节点并返回其下标
+    int NFA::newNode(NFAEdgeType edgeType) {
+        nodes.emplace_back(edgeType);
+        return (int) nodes.size() - 1;
     }
 
-    //单个字符,其情况包罗万象
-    void NFA::singleChar(NFANodePair &pair) {
-        pair.start = std::make_shared<NFANode>(NFAEdgeType::normalChar);
-        pair.end = std::make_shared<NFANode>();
-        pair.start->next1 = pair.end;
-        pair.start->edgeValue = lexer.getCurrentChar();
+    //空串,头尾为同一节点
+    void NFA::emptyString(NFANodePair &pair) {
+        pair.start = newNode();
+        pair.end = pair.start;
+    }
 
-        lexer.advance();
+    //单个字符,其情况包罗万象
+    void NFA::singleChar(NFANodePair &pair, char c) {
+        pair.start = newNode(NFAEdgeType::normalChar);
+        pair.end = newNode();
+        nodes[pair.start].next1 = pair.end;
+        nodes[pair.start].edgeValue = c;
     }
 
     //.字符
     void NFA::anyChar(NFANodePair &pair) {
-        if (!lexer.match(RegExToken::AnyChar))
-            return;
-        pair.start = std::make_shared<NFANode>(NFAEdgeType::charCollection);
-        pair.start->edgeValue = '.';
-        pair.end = std::make_shared<NFANode>();
-        pair.start->next1 = pair.end;
-        lexer.advance();
-    }
-
-    //字符集
-    void NFA::charCollection(NFANodePair &pair) {
-        //如果是字符集则currentToken应该为[
-        if (!lexer.match(RegExToken::LeftCollection))
-            return;
-        bool needReverse = false;
-        lexer.advance();
-        if (lexer.match(RegExToken::CharBegin))
-            needReverse = true;
-        pair.start = std::make_shared<NFANode>(NFAEdgeType::charCollection);
-        pair.end = std::make_shared<NFANode>();
-        pair.start->next1 = pair.end;
-        char first = '\0';
-        std::shared_ptr<hashSet<char>> &nodeSet = pair.start->edgeSet;
-        while (!lexer.match(RegExToken::RightCollection)) {
-            //如果遇到破折号
-            if (lexer.match(RegExToken::Dash)) {
-                //查看前一个字符是否为字母或数字,否则应该视为正常的-符号
-                if (('a' <= first && first <= 'z') ||
-                    ('0' <= first && first <= '9') ||
-                    ('A' <= first && first <= 'Z')) {
-                    lexer.advance();
-                    char last = lexer.getCurrentChar();
-                    for (char c = first; c <= last; ++c) nodeSet->emplace(c);
-                } else {
-                    first = lexer.getCurrentChar();
-                    nodeSet->emplace(first);
-                }
-            } else {
-                first = lexer.getCurrentChar();
-                nodeSet->emplace(first);
-            }
-            lexer.advance();
-        }
-        if (needReverse)
-            pair.start->inverseCharSet();
-        lexer.advance();
-    }
-
-    //转义字符
-    void NFA::escapeChar(NFANodePair &pair) {
-        if (!lexer.match(RegExToken::EscapeChar))
-            return;
-        static char escapeCharacter[] = {
-            'd',  //代表数字
-            'D',  //代表非数字
-            'w',  //代表字符
-            'W'   //代表非字符
-        };
-        bool isCharSetFlag = false;
-        char currentChar = lexer.getCurrentChar();
-        for (char c : escapeCharacter) {
-            if (c == currentChar) {
-                isCharSetFlag = true;
-                break;
-            }
-        }
-        NFAEdgeType type = isCharSetFlag ? NFAEdgeType::charCollection : NFAEdgeType::normalChar;
-        pair.start = std::make_shared<NFANode>(type);
-        pair.end = std::make_shared<NFANode>();
-        pair.start->next1 = pair.end;
-        if (isCharSetFlag) {
-            std::shared_ptr<hashSet<char>> &nodeSet = pair.start->edgeSet;
-            if (currentChar == 'd' || currentChar == 'D') {
-                for (char c = '0'; c <= '9'; ++c)
-                    nodeSet->emplace(c);
-                if (currentChar == 'D')
-                    pair.start->inverseCharSet();
-            } else if (currentChar == 'w' || currentChar == 'W') {
-                for (char c = 'a'; c <= 'z'; ++c)
-                    nodeSet->emplace(c);
-                for (char c = 'A'; c <= 'Z'; ++c)
-                    nodeSet->emplace(c);
-                if (currentChar == 'W')
-                    pair.start->inverseCharSet();
-            }
-        }
-        lexer.advance();
-    }
-
-    // term ::= char | "[" char "-" char "]" | .
-    void NFA::term(NFANodePair &pair) {
-        switch (lexer.getCurrentToken()) {
-        case RegExToken::AnyChar:
-            anyChar(pair);
-            break;
-        case RegExToken::LeftCollection:
-            charCollection(pair);
-            break;
-        case RegExToken::EscapeChar:
-            escapeChar(pair);
-            break;
-        default:
-            singleChar(pair);
-            break;
-        }
+        pair.start = newNode(NFAEdgeType::charCollection);
+        pair.end = newNode();
+        nodes[pair.start].edgeValue = '.';
+        nodes[pair.start].next1 = pair.end;
+    }
+
+    //字符集,多个节点可共享同一字符集
+    void NFA::charCollection(NFANodePair &pair, const std::shared_ptr<const CharSet> &charSet) {
+        pair.start = newNode();
+        pair.end = newNode();
+        nodes[pair.start].edgeType = NFAEdgeType::charCollection;
+        nodes[pair.start].edgeSet = charSet;
+        nodes[pair.start].next1 = pair.end;
+    }
+
+    //零宽断言,只有满足assertion时才能通过
+    void NFA::lookAssertion(NFANodePair &pair, uint8_t assertion) {
+        pair.start = newNode(NFAEdgeType::look);
+        pair.end = newNode();
+        nodes[pair.start].look = assertion;
+        nodes[pair.start].next1 = pair.end;
+        hasLook = true;
     }
 
     //*闭包
     void NFA::kleeneClosure(NFANodePair &pair) {
-        std::shared_ptr<NFANode> start = std::make_shared<NFANode>(NFAEdgeType::epslion);
-        std::shared_ptr<NFANode> end = std::make_shared<NFANode>();
-        start->next1 = pair.start;
-        start->next2 = end;
+        int start = newNode(NFAEdgeType::epslion);
+        int end = newNode();
+        nodes[start].next1 = pair.start;
+        nodes[start].next2 = end;
 
-        //由于*闭包会导致成环,因此一定要注意应该使用loop指针
-        pair.end->loop = pair.start;
-        pair.end->next1 = end;
-        pair.end->edgeType = NFAEdgeType::epslion;
+        //由于*闭包会导致成环,因此使用loop边回到开头
+        nodes[pair.end].loop = pair.start;
+        nodes[pair.end].next1 = end;
+        nodes[pair.end].edgeType = NFAEdgeType::epslion;
 
         pair.start = start;
         pair.end = end;
-
-        lexer.advance();
     }
 
     //+闭包
     void NFA::positiveClosure(NFANodePair &pair) {
-        std::shared_ptr<NFANode> start = std::make_shared<NFANode>(NFAEdgeType::epslion);
-        std::shared_ptr<NFANode> end = std::make_shared<NFANode>();
-        start->next1 = pair.start;
+        int start = newNode(NFAEdgeType::epslion);
+        int end = newNode();
+        nodes[start].next1 = pair.start;
 
-        //由于+闭包会导致成环,因此一定要注意应该使用loop指针
-        pair.end->loop = pair.start;
-        pair.end->next1 = end;
-        pair.end->edgeType = NFAEdgeType::epslion;
+        //由于+闭包会导致成环,因此使用loop边回到开头
+        nodes[pair.end].loop = pair.start;
+        nodes[pair.end].next1 = end;
+        nodes[pair.end].edgeType = NFAEdgeType::epslion;
 
         pair.start = start;
         pair.end = end;
-        lexer.advance();
     }
 
     //?闭包
     void NFA::questionClosure(NFANodePair &pair) {
-        std::shared_ptr<NFANode> start = std::make_shared<NFANode>(NFAEdgeType::epslion);
-        std::shared_ptr<NFANode> end = std::make_shared<NFANode>();
+        int start = newNode(NFAEdgeType::epslion);
+        int end = newNode();
 
-        start->next1 = pair.start;
-        start->next2 = end;
+        nodes[start].next1 = pair.start;
+        nodes[start].next2 = end;
 
-        pair.end->next1 = end;
-        pair.end->edgeType = NFAEdgeType::epslion;
+        nodes[pair.end].next1 = end;
+        nodes[pair.end].edgeType = NFAEdgeType::epslion;
 
         pair.start = start;
         pair.end = end;
-        lexer.advance();
-    }
-
-    //{n,m}闭包
-    void NFA::repeatClosure(NFANodePair &pair) {
-        if (!lexer.match(RegExToken::LeftBrace))
-            return;
-        // n,m闭包
-        int n = 0;
-        //计算n
-        while (true) {
-            if (lexer.match(RegExToken::RightBrace))
-                break;
-            else if (lexer.match(RegExToken::SingleChar)) {
-                char c = lexer.getCurrentChar();
-                if ('0' <= c && c <= '9') {
-                    n = n * 10 + c - '0';
-                } else {
-                    if (c != ',')
-                        throw RegexException();
-                    else
-                        break;
-                }
-            }
-            lexer.advance();
-        }
-        //此时为遇到逗号或者右大括号
-        if (lexer.match(RegExToken::RightBrace)) {
-            //如果此时为右大括号,则说明正则为{n}形式
-            repeatClosureHelper(pair, n, -2);
-        } else {
-            //否则此时应该为lexer.getCurrentChar()应该为逗号
-            int m = 0;
-            lexer.advance();
-            if (lexer.match(RegExToken::RightBrace)) {
-                //说明此时 m 应该为无穷
-                repeatClosureHelper(pair, n, -1);
-            } else {
-                //否则应该计算m
-                while (!lexer.match(RegExToken::RightBrace)) {
-                    char c = lexer.getCurrentChar();
-                    if ('0' <= c && c <= '9')
-                        m = m * 10 + c - '0';
-                    else
-                        throw RegexException();
-                    lexer.advance();
-                }
-                repeatClosureHelper(pair, n, m);
-            }
+    }
+
+    //复制节点下标在[begin,end)中的片段,片段内部的边指向对应的新节点
+    NFANodePair NFA::copyFragment(const NFANodePair &pair, int begin, int end) {
+        int offset = (int) nodes.size() - begin;
+        nodes.reserve(nodes.size() + (end - begin));
+        auto remap = [&](int index) {
+            return begin <= index && index < end ? index + offset : index;
+        };
+        for (int i = begin; i < end; i++) {
+            NFANode node = nodes[i];
+            node.next1 = remap(node.next1);
+            node.next2 = remap(node.next2);
+            node.loop = remap(node.loop);
+            nodes.emplace_back(std::move(node));
         }
-        lexer.advance();
+        return {pair.start + offset, pair.end + offset};
     }
 
-    //{n,m}闭包辅助函数,m = -2时表示不存在,m = -1时表示无限
-    void NFA::repeatClosureHelper(NFANodePair &pair, int n, int m) {
-        if (m > 0 && n > m) {
+    //{n,m}闭包辅助函数,m = -1时表示无限
+    void NFA::repeatClosureHelper(NFANodePair &pair, int begin, int n, int m, const CompileBudget *budget) {
+        if (m >= 0 && n > m) {
             throw RegexException();
         }
         if (n == 0 && m == -1) {
@@ -307,246 +195,127 @@ namespace zhRegex {
         } else if (n == 0 && m == 1) {
             //等价?闭包
             questionClosure(pair);
+        } else if (n == 0 && m == 0) {
+            emptyString(pair);
         } else {
-            if (n == 0 && m == 0) {
-                pair.start = nullptr;
-                pair.end = nullptr;
-                return;
+            //先复制出所需的全部片段,再依次连接
+            int end = (int) nodes.size();
+            int count = m == -1 ? n : m;
+            if (budget != nullptr) {
+                //每个片段复制一份,每个可选或可重复的片段再加两个节点
+                budget->checkNFANodes(nodes.size() + (size_t) (count - 1) * (end - begin) + 2 * (size_t) count);
+                budget->checkTime();
             }
-            //{n,m}形态
-            //保存start
-            std::shared_ptr<NFANode> saveHead = pair.start;
-            std::shared_ptr<NFANode> prevTail;
-            NFAEdgeType type = pair.start->edgeType;
-            for (int i = 1; i < n; i++) {
-                std::shared_ptr<NFANode> newStart = std::make_shared<NFANode>(type);
-                newStart->edgeType = type;
-                newStart->edgeValue = pair.start->edgeValue;
-                newStart->edgeSet = pair.start->edgeSet;
-
-                std::shared_ptr<NFANode> newEnd = std::make_shared<NFANode>();
-                newStart->next1 = newEnd;
-
-                //将新的term和以前的term连接
-                pair.end->next1 = newStart;
-                pair.end->edgeType = NFAEdgeType::epslion;
-
-                //更新pair
-                if (i == n - 1) {
-                    prevTail = pair.end;
-                }
-                pair.start = newStart;
-                pair.end = newEnd;
+            std::vector<NFANodePair> copies(count, pair);
+            for (int i = 1; i < count; i++) {
+                copies[i] = copyFragment(pair, begin, end);
             }
-            //{n,m}形态(n不可能为负数,m为-2或-1时不会运行以下代码)
-            for (int i = n; i < m; i++) {
-                std::shared_ptr<NFANode> newStart = std::make_shared<NFANode>(type);
-                newStart->edgeType = type;
-                newStart->edgeValue = pair.start->edgeValue;
-                newStart->edgeSet = pair.start->edgeSet;
-
-                std::shared_ptr<NFANode> newEnd = std::make_shared<NFANode>(NFAEdgeType::epslion);
-                newStart->next1 = newEnd;
-
-                // epslion边
-                std::shared_ptr<NFANode> newHead = std::make_shared<NFANode>(NFAEdgeType::epslion);
-                std::shared_ptr<NFANode> newTail = std::make_shared<NFANode>();
-
-                newHead->next1 = newStart;
-                newHead->next2 = newTail;
-                newEnd->next1 = newTail;
-
-                //连接新term和老term
-                pair.end->edgeType = NFAEdgeType::epslion;
-                pair.end->next1 = newHead;
-
-                //更新pair
-                pair.end = newTail;
+            for (int i = n; i < count; i++) {
+                //n之后的片段都是可选的
+                questionClosure(copies[i]);
             }
             if (m == -1) {
-                pair.end->edgeType = NFAEdgeType::epslion;
-                pair.end->loop = prevTail;
-                //需要新构造一个tail
-                std::shared_ptr<NFANode> tail = std::make_shared<NFANode>();
-                pair.end->next1 = tail;
-                pair.end = tail;
+                //{n,}形态,最后一个片段可重复
+                positiveClosure(copies[n - 1]);
             }
-            //最后更新tail和head
-            pair.start = saveHead;
-        }
-    }
-
-    // factor ::= (("(")("^")term("$")(")") | ("(")("^")term("*" | "+" | "?" | "{n,m}")($)(")"))*
-    void NFA::factor(NFANodePair &pair) {
-        try {
-            //先看是否存在左括号
-            if (lexer.match(RegExToken::LeftParen))
-                lexer.advance();
-            //^符号
-            if (lexer.match(RegExToken::CharBegin))
-                lexer.advance();
-
-            term(pair);
-            //闭包符
-            switch (lexer.getCurrentToken()) {
-            case RegExToken::Kleene:
-                //*闭包
-                kleeneClosure(pair);
-                break;
-            case RegExToken::Positive:
-                //+闭包
-                positiveClosure(pair);
-                break;
-            case RegExToken::Question:
-                //?闭包
-                questionClosure(pair);
-                break;
-            case RegExToken::LeftBrace:
-                //{n,m}闭包
-                repeatClosure(pair);
-                break;
-            default:
-                break;
+            pair = copies[0];
+            for (int i = 1; i < count; i++) {
+                connect(pair, copies[i]);
             }
-
-            //是否存在右括号
-            if (lexer.match(RegExToken::RightParen))
-                lexer.advance();
-            //$符号
-            if (lexer.match(RegExToken::CharEnd))
-                lexer.advance();
-        } catch (RegexException &e) {
-            printf("%s", e.what());
-            return;
         }
     }
 
-    //能够构建factor的符号
-    bool NFA::canFactor(RegExToken type) {
-        static RegExToken symbol[] = {
-            RegExToken::LeftParen,
-            RegExToken::LeftCollection,
-            RegExToken::LeftBrace,
-            RegExToken::CharBegin,
-            RegExToken::SingleChar,
-            RegExToken::AnyChar,
-            RegExToken::Dash,
-            RegExToken::EscapeChar};
-        for (auto i : symbol) {
-            if (type == i)
-                return true;
-        }
-        return false;
-    }
-
-    // factorConnect ::= factor | factor·factor*
-    void NFA::factorConnect(NFANodePair &pair) {
-        if (canFactor(lexer.getCurrentToken()))
-            factor(pair);
-        while (canFactor(lexer.getCurrentToken())) {
-            NFANodePair childPair;
-            if (lexer.getCurrentChar() == '(') {
-                groupExpression(childPair);
-            } else {
-                factor(childPair);
-            }
-            //头尾相连即可
-            pair.end->next1 = childPair.start;
-            pair.end->edgeType = NFAEdgeType::epslion;
-            pair.end = childPair.end;
-        }
+    //头尾相连即可
+    void NFA::connect(NFANodePair &pair, const NFANodePair &next) {
+        nodes[pair.end].next1 = next.start;
+        nodes[pair.end].edgeType = NFAEdgeType::epslion;
+        pair.end = next.end;
     }
 
-    // expression ::= factorConnect ("|" factorConnect)*
-    void NFA::expression(NFANodePair &pair) {
-        factorConnect(pair);
-        NFANodePair childPair;
-        while (lexer.match(RegExToken::Or)) {
-            lexer.advance();
-            factorConnect(childPair);
+    //或
+    void NFA::alternate(NFANodePair &pair, const NFANodePair &other) {
+        int start = newNode(NFAEdgeType::epslion);
+        nodes[start].next1 = other.start;
+        nodes[start].next2 = pair.start;
 
-            std::shared_ptr<NFANode> start = std::make_shared<NFANode>(NFAEdgeType::epslion);
-            start->next1 = childPair.start;
-            start->next2 = pair.start;
+        int end = newNode();
+        nodes[other.end].next1 = end;
+        nodes[other.end].edgeType = NFAEdgeType::epslion;
+        nodes[pair.end].next1 = end;
+        nodes[pair.end].edgeType = NFAEdgeType::epslion;
 
-            std::shared_ptr<NFANode> end = std::make_shared<NFANode>();
-            childPair.end->next1 = end;
-            childPair.end->edgeType = NFAEdgeType::epslion;
-            pair.end->next1 = end;
-            pair.end->edgeType = NFAEdgeType::epslion;
-
-            pair.start = start;
-            pair.end = end;
-        }
-    }
-
-    // groupExpression ::= ("(" expression ")")*
-    void NFA::groupExpression(NFANodePair &pair) {
-        if (lexer.match(RegExToken::LeftParen)) {
-            lexer.advance();
-            expression(pair);
-            if (lexer.match(RegExToken::RightParen))
-                lexer.advance();
-        } else if (lexer.match(RegExToken::Eof)) {
-            return;
-        } else {
-            expression(pair);
-        }
-        //解析?,*,+
-        char c = lexer.getCurrentChar();
-        switch (c) {
-        case '?':
-            questionClosure(pair);
-            break;
-        case '+':
-            positiveClosure(pair);
-            break;
-        case '*':
-            kleeneClosure(pair);
-            break;
-        default:
-            lexer.advance();
-            break;
-        }
+        pair.start = start;
+        pair.end = end;
     }
 
-    // regexExpression ::= ("(" groupExpression ")")*
-    void NFA::regexExpression(NFANodePair &pair) {
-        if (lexer.match(RegExToken::LeftParen)) {
-            lexer.advance();
-            groupExpression(pair);
-            if (lexer.match(RegExToken::RightParen))
-                lexer.advance();
-        } else if (lexer.match(RegExToken::Eof)) {
-            return;
-        } else {
-            groupExpression(pair);
-        }
-        //解析多个(),用·连接即可
-        while (true) {
-            NFANodePair childPair;
-            if (lexer.match(RegExToken::LeftParen)) {
-                lexer.advance();
-                groupExpression(childPair);
-                pair.end->next1 = childPair.start;
-                pair.end->edgeType = NFAEdgeType::epslion;
-                pair.end = childPair.end;
-
-                if (lexer.match(RegExToken::RightParen))
-                    lexer.advance();
-            } else if (lexer.match(RegExToken::Eof)) {
-                return;
-            } else {
-                groupExpression(childPair);
-                pair.end->next1 = childPair.start;
-                pair.end->edgeType = NFAEdgeType::epslion;
-                pair.end = childPair.end;
+    //由AST自底向上(非递归)构造NFA
+    //后序遍历保证每个AST节点对应的NFA节点连续存放,{n,m}闭包可以直接按下标复制片段
+    void NFA::build(const RegexAST &ast, const CompileBudget *budget) {
+        int size = (int) ast.nodes.size();
+        std::vector<NFANodePair> fragments(size);
+        std::vector<int> begins(size);
+        //(AST节点,子节点是否已经处理)
+        std::vector<std::pair<int, bool>> astStack;
+        astStack.emplace_back(ast.root, false);
+        nodes.reserve(size * 2);
+        while (!astStack.empty()) {
+            auto [index, expanded] = astStack.back();
+            astStack.pop_back();
+            const ASTNode &astNode = ast[index];
+            if (!expanded) {
+                begins[index] = (int) nodes.size();
+                astStack.emplace_back(index, true);
+                for (auto it = astNode.children.rbegin(); it != astNode.children.rend(); ++it) {
+                    astStack.emplace_back(*it, false);
+                }
+                continue;
+            }
+            NFANodePair &pair = fragments[index];
+            switch (astNode.type) {
+            case ASTNodeType::singleChar:
+                singleChar(pair, astNode.value);
+                break;
+            case ASTNodeType::anyChar:
+                anyChar(pair);
+                break;
+            case ASTNodeType::charCollection:
+                charCollection(pair, astNode.charSet);
+                break;
+            case ASTNodeType::group:
+                pair = fragments[astNode.children[0]];
+                break;
+            case ASTNodeType::look:
+                lookAssertion(pair, (uint8_t) astNode.value);
+                break;
+            case ASTNodeType::concat:
+                pair = fragments[astNode.children[0]];
+                for (size_t i = 1; i < astNode.children.size(); i++) {
+                    connect(pair, fragments[astNode.children[i]]);
+                }
+                break;
+            case ASTNodeType::alternate:
+                pair = fragments[astNode.children[0]];
+                for (size_t i = 1; i < astNode.children.size(); i++) {
+                    alternate(pair, fragments[astNode.children[i]]);
+                }
+                break;
+            case ASTNodeType::repeat:
+                pair = fragments[astNode.children[0]];
+                repeatClosureHelper(pair, begins[index], astNode.min, astNode.max, budget);
+                break;
+            default:
+                //空串
+                emptyString(pair);
+                break;
             }
         }
+        head = fragments[ast.root].start;
+        if (budget != nullptr)
+            budget->checkNFANodes(nodes.size());
     }
 
     // closure算法
-    hashSet<NFANode *> NFA::closure(hashSet<NFANode *> &closureSet) {
+    hashSet<NFANode *> NFA::closure(hashSet<NFANode *> &closureSet, uint8_t looks) {
         if (closureSet.empty())
             return closureSet;
         // 把传入集合里的所有节点压入栈中
@@ -560,30 +329,18 @@ namespace zhRegex {
         while (!nodeStack.empty()) {
             NFANode *node = nodeStack.top();
             nodeStack.pop();
-            NFANode *next1 = node->next1.get();
-            if (next1 != nullptr && node->edgeType == NFAEdgeType::epslion) {
-                if (closureSet.find(next1) == closureSet.end()) {
-                    closureSet.emplace(next1);
-                    nodeStack.push(next1);
-                }
-            }
-
-            NFANode *next2 = node->next2.get();
-            if (next2 != nullptr && node->edgeType == NFAEdgeType::epslion) {
-                if (closureSet.find(next2) == closureSet.end()) {
-                    closureSet.emplace(next2);
-                    nodeStack.push(next2);
-                }
-            }
-            //大多数时候loopShared都为空
-            std::shared_ptr<NFANode> loopShared = node->loop.lock();
-            if (loopShared != nullptr) {
-                NFANode *loop = loopShared.get();
-                if (loop != nullptr && node->edgeType == NFAEdgeType::epslion) {
-                    if (closureSet.find(loop) == closureSet.end()) {
-                        closureSet.emplace(loop);
-                        nodeStack.push(loop);
-                    }
+            //look边只有在满足断言时才能通过
+            if (node->edgeType != NFAEdgeType::epslion
+                && !(node->edgeType == NFAEdgeType::look && (node->look & looks)))
+                continue;
+            //大多数时候loop都为-1
+            for (int next : {node->next1, node->next2, node->loop}) {
+                if (next < 0)
+                    continue;
+                NFANode *nextNode = &nodes[next];
+                if (closureSet.find(nextNode) == closureSet.end()) {
+                    closureSet.emplace(nextNode);
+                    nodeStack.push(nextNode);
                 }
             }
         }
@@ -595,24 +352,9 @@ namespace zhRegex {
         // DFAedge(s,c)为s集合中所有状态经过c能到到的集合
         hashSet<NFANode *> nextSet;
         for (NFANode *node : closureSet) {
-            if (node->edgeType == NFAEdgeType::normalChar && node->edgeValue == c) {
-                //单字符时
-                nextSet.emplace(node->next1.get());
-            } else if (node->edgeType == NFAEdgeType::charCollection) {
-                //字符集时
-                if (node->edgeValue == '.') {
-                    //匹配anyChar
-                    nextSet.emplace(node->next1.get());
-                } else {
-                    std::shared_ptr<hashSet<char>> &nodeChild = node->edgeSet;
-                    for (char childChar : *nodeChild) {
-                        //如果其子集中存在char c,则可访问
-                        if (childChar == c) {
-                            nextSet.emplace(node->next1.get());
-                            break;
-                        }
-                    }
-                }
+            //单字符、字符集或anyChar可接受c时
+            if (node->acceptChar(c)) {
+                nextSet.emplace(&nodes[node->next1]);
             }
         }
         //最后还得求一次闭包
@@ -620,54 +362,218 @@ namespace zhRegex {
         return nextSet;
     }
 
-    //获取DFA
-    DFA NFA::NFAToDFA() {
-        hashSet<NFANode *> currentStatus;
-        currentStatus.emplace(head.get());
-        currentStatus = NFA::closure(currentStatus);
+    //有序状态集合的closure,states同时作为工作队列,marks[i] == stamp表示节点i已在集合中
+    void NFA::closure(std::vector<uint32_t> &states, std::vector<uint32_t> &marks, uint32_t stamp,
+                      uint8_t looks) const {
+        for (uint32_t state : states)
+            marks[state] = stamp;
+        for (size_t i = 0; i < states.size(); i++) {
+            const NFANode &node = nodes[states[i]];
+            if (node.edgeType != NFAEdgeType::epslion
+                && !(node.edgeType == NFAEdgeType::look && (node.look & looks)))
+                continue;
+            for (int next : {node.next1, node.next2, node.loop}) {
+                if (next >= 0 && marks[next] != stamp) {
+                    marks[next] = stamp;
+                    states.push_back((uint32_t) next);
+                }
+            }
+        }
+        std::sort(states.begin(), states.end());
+    }
 
-        DFA dfa;
-        // closureMap用于记录closure集合是否重复
-        // key为closure集合,value为其对应的编号
-        hashMap<hashSet<NFANode *>, int, DFAMapHash, DFAMapEqual> closureMap;
-        std::vector<hashSet<NFANode *>> closureList;
-        closureMap[currentStatus] = (int)closureMap.size();
-        closureList.emplace_back(currentStatus);
-        dfa.statusMap.emplace_back(DFA::isFinalStatus(currentStatus));
-        for (int index = 0; index < closureMap.size(); index++) {
-            for (int c = CHAR_MIN; c <= CHAR_MAX; c++) {
-                hashSet<NFANode *> nfaClosure = NFA::DFAedge(closureList[index], (char)c);
-                if (nfaClosure.empty()) {
-                    continue;
+    //下标集合版本的DFAedge
+    void NFA::DFAedge(const std::vector<uint32_t> &states, char c, std::vector<uint32_t> &next,
+                      std::vector<uint32_t> &marks, uint32_t stamp) const {
+        next.clear();
+        for (uint32_t state : states) {
+            const NFANode &node = nodes[state];
+            if (node.acceptChar(c) && marks[node.next1] != stamp) {
+                marks[node.next1] = stamp;
+                next.push_back((uint32_t) node.next1);
+            }
+        }
+        closure(next, marks, stamp);
+    }
+
+    //子集构造
+    //状态集合为有序的节点下标数组,驻留在StateSetArena中;按字节等价类转移,每类只求一次DFAedge
+    //含零宽断言时,有look节点的集合末尾追加contextTag | 前一个字节的种类,转移前先按(种类,下一个字节)满足的断言求闭包;
+    //字节类额外按\n与单词字符细分,使同一类中的字节满足的断言相同
+    DFA NFA::subsetConstruction(unsigned threads, const CompileBudget *budget) {
+        std::vector<const NFANode *> edges;
+        for (const NFANode &node : nodes) {
+            if (node.edgeType == NFAEdgeType::normalChar || node.edgeType == NFAEdgeType::charCollection)
+                edges.push_back(&node);
+        }
+        //只用于细分字节类的边
+        NFANode newlineEdge(NFAEdgeType::normalChar);
+        newlineEdge.edgeValue = '\n';
+        NFANode wordEdge(NFAEdgeType::charCollection);
+        std::vector<const NFANode *> splitters = edges;
+        if (hasLook) {
+            CharSet words;
+            for (int b = 0; b < 256; b++) {
+                if (Look::isWordByte((char) b))
+                    words.add((char) b);
+            }
+            wordEdge.edgeSet = std::make_shared<const CharSet>(words);
+            splitters.push_back(&newlineEdge);
+            splitters.push_back(&wordEdge);
+        }
+        ByteClasses classes(splitters);
+        int classCount = classes.count();
+        //每个带字符边的节点可以接受的类
+        std::vector<std::vector<uint16_t>> nodeClasses(nodes.size());
+        for (const NFANode *edge : edges) {
+            classes.acceptedClasses(*edge, nodeClasses[edge - nodes.data()]);
+        }
+        //经过各类之后的种类,以及前一个字节的种类为context时各类满足的断言
+        constexpr uint32_t contextTag = 1u << 31;
+        std::vector<Look::Context> classContext(classCount);
+        std::vector<uint8_t> classLooks(Look::contextCount * classCount);
+        for (int cls = 0; cls < classCount; cls++) {
+            char c = classes.bytesOf(cls)[0];
+            classContext[cls] = Look::contextOf(c);
+            for (int context = 0; context < Look::contextCount; context++)
+                classLooks[context * classCount + cls] = Look::satisfied((Look::Context) context, (unsigned char) c);
+        }
+        //集合含有look节点时追加种类
+        auto addContext = [&](std::vector<uint32_t> &states, Look::Context context) {
+            if (!hasLook)
+                return;
+            for (uint32_t state : states) {
+                if (nodes[state].edgeType == NFAEdgeType::look) {
+                    states.push_back(contextTag | context);
+                    return;
+                }
+            }
+        };
+
+        //每个线程的临时空间,marks[i] == stamp表示节点i已在当前集合中
+        struct Scratch {
+            std::vector<uint32_t> marks;
+            uint32_t stamp = 0;
+            //buckets[cls]为经过类cls到达的节点,touched为非空的类
+            std::vector<std::vector<uint32_t>> buckets;
+            std::vector<int> touched;
+            //按断言求闭包后的集合,以及当前状态下各类满足的不同断言
+            std::vector<uint32_t> expanded;
+            std::vector<uint8_t> lookValues;
+        };
+        threads = std::max(threads, 1u);
+        std::vector<Scratch> scratches(threads);
+        for (Scratch &scratch : scratches) {
+            scratch.marks.assign(nodes.size(), 0);
+            scratch.buckets.resize(classCount);
+        }
+        //将states经过looksOf[cls] == looks的类到达的节点分桶,返回states中是否有终结点
+        auto fillBuckets = [&](Scratch &scratch, const uint32_t *states, size_t count, const uint8_t *looksOf,
+                               uint8_t looks) {
+            bool final = false;
+            for (size_t i = 0; i < count; i++) {
+                uint32_t state = states[i];
+                final = final || nodes[state].edgeType == NFAEdgeType::eofEdge;
+                for (uint16_t cls : nodeClasses[state]) {
+                    if (looksOf != nullptr && looksOf[cls] != looks)
+                        continue;
+                    if (scratch.buckets[cls].empty())
+                        scratch.touched.push_back(cls);
+                    scratch.buckets[cls].push_back((uint32_t) nodes[state].next1);
+                }
+            }
+            return final;
+        };
+        auto expand = [&](unsigned worker, const std::vector<uint32_t> &states, SubsetSuccessors &successors,
+                          std::vector<int> &acceptClasses) {
+            Scratch &scratch = scratches[worker];
+            if (states.empty() || !(states.back() & contextTag)) {
+                //与断言无关
+                if (fillBuckets(scratch, states.data(), states.size(), nullptr, 0)) {
+                    for (int cls = 0; cls < classCount; cls++)
+                        acceptClasses.push_back(cls);
                 }
-                // nfaClosure不存在,则需要加入新状态
-                if (closureMap.find(nfaClosure) == closureMap.end()) {
-                    closureMap[nfaClosure] = (int)closureMap.size();
-                    closureList.emplace_back(nfaClosure);
-                    dfa.statusMap.emplace_back(DFA::isFinalStatus(nfaClosure));
+            } else {
+                //按下一个字节满足的断言分组,每组求一次闭包
+                const uint8_t *looksOf = &classLooks[(states.back() & ~contextTag) * classCount];
+                scratch.lookValues.assign(looksOf, looksOf + classCount);
+                std::sort(scratch.lookValues.begin(), scratch.lookValues.end());
+                scratch.lookValues.erase(std::unique(scratch.lookValues.begin(), scratch.lookValues.end()),
+                                         scratch.lookValues.end());
+                for (uint8_t looks : scratch.lookValues) {
+                    scratch.expanded.assign(states.begin(), states.end() - 1);
+                    closure(scratch.expanded, scratch.marks, ++scratch.stamp, looks);
+                    if (fillBuckets(scratch, scratch.expanded.data(), scratch.expanded.size(), looksOf, looks)) {
+                        for (int cls = 0; cls < classCount; cls++) {
+                            if (looksOf[cls] == looks)
+                                acceptClasses.push_back(cls);
+                        }
+                    }
                 }
-                //这行表示,从closureList[index]状态经过c将转移到nfaClosure状态上
-                int currentStatusNumber = closureMap[closureList[index]];
-                while (dfa.table.size() <= currentStatusNumber) {
-                    //每次currentStatusNumber不存在则其对应的size应该刚好等于currentStatusNumber
-                    //因为statusNumber是一个个增加的
-                    dfa.table.emplace_back(hashMap<char, int>());
+            }
+            std::sort(scratch.touched.begin(), scratch.touched.end());
+            for (int cls : scratch.touched) {
+                std::vector<uint32_t> &nextStatus = scratch.buckets[cls];
+                //next1可能重复,closure中依靠marks去重
+                size_t unique = 0;
+                ++scratch.stamp;
+                for (uint32_t state : nextStatus) {
+                    if (scratch.marks[state] != scratch.stamp) {
+                        scratch.marks[state] = scratch.stamp;
+                        nextStatus[unique++] = state;
+                    }
                 }
-                //这行表示,从closureList[index]状态经过c将转移到nfaClosure状态上
-                dfa.table[closureMap[closureList[index]]][(char)c] = closureMap[nfaClosure];
+                nextStatus.resize(unique);
+                closure(nextStatus, scratch.marks, scratch.stamp);
+                addContext(nextStatus, classContext[cls]);
+                successors.emplace_back(cls, nextStatus);
+                nextStatus.clear();
             }
+            scratch.touched.clear();
+        };
+        //isFinal只在串行阶段调用,可以使用scratches[0];带种类的集合按位于文本结尾时满足的断言判断
+        auto isFinal = [&](const std::vector<uint32_t> &states) {
+            const std::vector<uint32_t> *final = &states;
+            if (!states.empty() && (states.back() & contextTag)) {
+                Scratch &scratch = scratches[0];
+                scratch.expanded.assign(states.begin(), states.end() - 1);
+                closure(scratch.expanded, scratch.marks, ++scratch.stamp,
+                        Look::satisfied((Look::Context) (states.back() & ~contextTag), -1));
+                final = &scratch.expanded;
+            }
+            for (uint32_t state : *final) {
+                if (state < contextTag && nodes[state].edgeType == NFAEdgeType::eofEdge)
+                    return true;
+            }
+            return false;
+        };
+
+        //每种上下文一个起始点,不含断言时它们是同一个集合
+        std::vector<std::vector<uint32_t>> starts(Look::contextCount);
+        for (int context = 0; context < Look::contextCount; context++) {
+            starts[context].push_back((uint32_t) head);
+            closure(starts[context], scratches[0].marks, ++scratches[0].stamp);
+            addContext(starts[context], (Look::Context) context);
         }
-        //如果最后statusMap.size() > table.size(),则说明终态没有表现出来
-        if (dfa.statusMap.size() > dfa.table.size()) {
-            dfa.table.emplace_back(hashMap<char, int>());
-        }
+        DFA dfa;
+        std::vector<int> startIds = buildSubsets(classes, starts, threads, expand, isFinal, dfa.table, dfa.statusMap,
+                                                 hasLook ? &dfa.lookAccept : nullptr, budget);
+        std::copy(startIds.begin(), startIds.end(), dfa.startStates);
+        dfa.startNode = startIds[Look::atTextBegin];
+        return dfa;
+    }
+
+    //获取DFA
+    DFA NFA::NFAToDFA(unsigned threads) {
+        DFA dfa = subsetConstruction(threads);
+        dfa.finalize();
         return dfa;
     }
 
     //整个input字符串是否匹配pattern
     bool NFA::match(std::string_view &input) {
         hashSet<NFANode *> closureSet;
-        closureSet.emplace(head.get());
+        closureSet.emplace(&nodes[head]);
         //输入空字时可达到的节点称为closure闭包
         closure(closureSet);
         // 首先先计算出开始节点的closure集合开始遍历输入的字符串
@@ -675,11 +581,18 @@ namespace zhRegex {
         // 只要当前集合有某个状态节点没有连接到其它节点，它就是一个可接收的状态节点
         // 能被当前NFA接收还需要一个条件就是当前字符已经全匹配完了
         int len = (int)input.size();
+        //前一个字节的种类,决定了当前位置满足的断言
+        Look::Context context = Look::atTextBegin;
         for (int i = 0; i < len; i++) {
+            if (hasLook)
+                closure(closureSet, Look::satisfied(context, (unsigned char) input[i]));
             closureSet = DFAedge(closureSet, input[i]);
             if (closureSet.empty())
                 return false;
+            context = Look::contextOf(input[i]);
         }
+        if (hasLook)
+            closure(closureSet, Look::satisfied(context, -1));
         //最后查看closureSet中是否存在终结点
         for (NFANode *nfaNode : closureSet) {
             if (nfaNode->edgeType == NFAEdgeType::eofEdge)
@@ -688,50 +601,148 @@ namespace zhRegex {
         return false;
     }
 
-    //找出所有匹配的string
-    std::vector<std::string_view> NFA::contains(std::string_view &input) {
-        std::vector<std::string_view> ans;
+    // input是否存在匹配pattern的前缀,每读入一个字节前检查当前集合能否作为终态
+    bool NFA::matchPrefix(std::string_view &input) {
+        hashSet<NFANode *> closureSet;
+        closureSet.emplace(&nodes[head]);
+        closure(closureSet);
+        auto isFinal = [](const hashSet<NFANode *> &set) {
+            for (NFANode *nfaNode : set) {
+                if (nfaNode->edgeType == NFAEdgeType::eofEdge)
+                    return true;
+            }
+            return false;
+        };
+        Look::Context context = Look::atTextBegin;
+        for (char c : input) {
+            if (hasLook)
+                closure(closureSet, Look::satisfied(context, (unsigned char) c));
+            if (isFinal(closureSet))
+                return true;
+            closureSet = DFAedge(closureSet, c);
+            if (closureSet.empty())
+                return false;
+            context = Look::contextOf(c);
+        }
+        if (hasLook)
+            closure(closureSet, Look::satisfied(context, -1));
+        return isFinal(closureSet);
+    }
+
+    //占用的内存字节数
+    size_t NFA::memoryUsage() const {
+        size_t bytes = sizeof(NFA) + nodes.capacity() * sizeof(NFANode);
+        //字符集可能被多个节点共享,只统计一次
+        hashSet<const CharSet *> charSets;
+        for (const NFANode &node: nodes) {
+            if (node.edgeSet != nullptr && charSets.emplace(node.edgeSet.get()).second)
+                bytes += sizeof(CharSet);
+        }
+        return bytes;
+    }
+
+    //依次报告所有匹配的位置
+    //状态集合为节点下标数组,使用线程的MatchScratch,不为每个字节新建集合;emit中不能再调用NFA的contains
+    template <typename Emit>
+    void NFA::forEachMatch(std::string_view input, Emit &&emit) {
         int len = input.size();
+        MatchScratch &scratch = matchScratch(nodes.size());
+        std::vector<uint32_t> &marks = scratch.marks;
         //初始状态的闭包
-        hashSet<NFANode *> startSet;
-        startSet.emplace(head.get());
-        closure(startSet);
-        //用于转换的set
-        hashSet<NFANode *> closureSet = startSet;
+        std::vector<uint32_t> &startSet = scratch.start;
+        startSet.assign(1, (uint32_t) head);
+        closure(startSet, marks, scratch.nextStamp());
+        //用于转换的集合
+        std::vector<uint32_t> &closureSet = scratch.current;
+        std::vector<uint32_t> &nextClosureSet = scratch.next;
+        closureSet = startSet;
+        auto isFinal = [this](const std::vector<uint32_t> &set) {
+            for (uint32_t state : set) {
+                if (nodes[state].edgeType == NFAEdgeType::eofEdge)
+                    return true;
+            }
+            return false;
+        };
         int index = 0;
+        //前一个字节的种类,决定了当前位置满足的断言
+        Look::Context context = Look::atTextBegin;
         //然后通过input进行状态转移
         for (int i = 0; i < len; i++) {
-            hashSet<NFANode *> nextClosureSet = DFAedge(closureSet, input[i]);
+            uint8_t looks = hasLook ? Look::satisfied(context, (unsigned char) input[i]) : 0;
+            if (hasLook)
+                closure(closureSet, marks, scratch.nextStamp(), looks);
+            DFAedge(closureSet, input[i], nextClosureSet, marks, scratch.nextStamp());
             if (nextClosureSet.empty()) {
                 //说明转移失败,字符不匹配
                 //判断当前closureSet中是否存在终结状态
-                for (NFANode *node : closureSet) {
-                    //存在终结态
-                    if (node->edgeType == NFAEdgeType::eofEdge) {
-                        std::string_view s = input.substr(index, i - index);
-                        ans.emplace_back(s);
-                        break;
-                    }
-                }
+                if (isFinal(closureSet))
+                    emit((size_t) index, (size_t) (i - index));
                 //之后更新index并重置状态为初始状态
                 index = i;
                 closureSet = startSet;
+                if (hasLook)
+                    closure(closureSet, marks, scratch.nextStamp(), looks);
+                DFAedge(closureSet, input[i], nextClosureSet, marks, scratch.nextStamp());
             }
-            nextClosureSet = DFAedge(closureSet, input[i]);
-            if (!nextClosureSet.empty())
-                closureSet = nextClosureSet;
-            else
+            if (!nextClosureSet.empty()) {
+                closureSet.swap(nextClosureSet);
+            } else {
                 index = i + 1;
+                closureSet = startSet;
+            }
+            context = Look::contextOf(input[i]);
         }
+        if (hasLook)
+            closure(closureSet, marks, scratch.nextStamp(), Look::satisfied(context, -1));
         //最末尾情况
-        for (NFANode *node : closureSet) {
-            //存在终结态
-            if (node->edgeType == NFAEdgeType::eofEdge) {
-                std::string_view s = input.substr(index, len - index + 1);
-                ans.emplace_back(s);
-                break;
+        if (isFinal(closureSet))
+            emit((size_t) index, (size_t) (len - index));
+    }
+
+    //找出所有匹配的string
+    std::vector<std::string_view> NFA::contains(std::string_view &input) {
+        std::vector<std::string_view> ans;
+        forEachMatch(input, [&](size_t offset, size_t length) { ans.emplace_back(input.substr(offset, length)); });
+        return ans;
+    }
+
+    //找出所有匹配,直接写入out
+    void NFA::contains(std::string_view input, MatchBuffer &out, uint32_t patternId) {
+        forEachMatch(input, [&](size_t offset, size_t length) { out.push(offset, length, patternId); });
+    }
+
+    //每读入一个字节后把初始状态的闭包并入当前集合,相当于在每个位置重新开始匹配
+    bool NFA::isMatchAnywhere(std::string_view input) {
+        hashSet<NFANode *> startSet;
+        startSet.emplace(&nodes[head]);
+        closure(startSet);
+        hashSet<NFANode *> closureSet = startSet;
+        auto isFinal = [](const hashSet<NFANode *> &set) {
+            for (NFANode *nfaNode : set) {
+                if (nfaNode->edgeType == NFAEdgeType::eofEdge)
+                    return true;
             }
+            return false;
+        };
+        Look::Context context = Look::atTextBegin;
+        for (char c : input) {
+            if (hasLook)
+                closure(closureSet, Look::satisfied(context, (unsigned char) c));
+            if (isFinal(closureSet))
+                return true;
+            closureSet = DFAedge(closureSet, c);
+            closureSet.insert(startSet.begin(), startSet.end());
+            context = Look::contextOf(c);
         }
-        return ans;
+        if (hasLook)
+            closure(closureSet, Look::satisfied(context, -1));
+        return isFinal(closureSet);
+    }
+
+    // contains找到的匹配个数
+    size_t NFA::count(std::string_view input) {
+        size_t matches = 0;
+        forEachMatch(input, [&](size_t, size_t) { matches++; });
+        return matches;
     }
-}  // namespace zhRegex
\ No newline at end of file
+}  // namespace zhRegex
\ No newline at end of file
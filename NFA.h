@@ -1,6 +1,8 @@
 #ifndef _ZH_NFA_H_
 #define _ZH_NFA_H_
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <stack>
 #include <string>
@@ -8,8 +10,12 @@
 #include <unordered_set>
 #include <vector>
 
-#include "Lexer.h"
+#include "ASTOptimizer.h"
+#include "CompileLimits.h"
+#include "Look.h"
+#include "Parser.h"
 #include "Pattern.h"
+#include "RegexAST.h"
 #include "Token.h"
 
 /*
@@ -25,38 +31,45 @@ term ::= char | "[" char "-" char "]" | .
 namespace zhRegex {
     class DFA;
 
-    struct DFAMapHash;
-    struct DFAMapEqual;
-
     enum class NFAEdgeType {
         eofEdge,        //无边,为终结
         epslion,        // 1或2条epslion边
         normalChar,     //普通单词
-        charCollection  //单词集合
+        charCollection, //单词集合
+        look            //零宽断言,当前位置满足look中的断言时才能通过的epslion边
     };
 
-    // NFA节点
+    // NFA节点,所有节点连续存放在NFA中,以下标互相引用
     struct NFANode {
-        char edgeValue;
-        NFAEdgeType edgeType;
-        std::shared_ptr<hashSet<char>> edgeSet;
-        std::shared_ptr<NFANode> next1;
-        std::shared_ptr<NFANode> next2;
-        //此weak_ptr专门用于+和*闭包会出现的环形,否则会导致循环引用
-        std::weak_ptr<NFANode> loop;
-
-        NFANode();
+        char edgeValue = '\0';
+        NFAEdgeType edgeType = NFAEdgeType::eofEdge;
+        std::shared_ptr<const CharSet> edgeSet;
+        //下一个节点的下标,-1表示不存在
+        int next1 = -1;
+        int next2 = -1;
+        //+和*闭包会出现的环形边
+        int loop = -1;
+        //look边的断言(Look::textBegin等)
+        uint8_t look = 0;
+
+        NFANode() = default;
 
         explicit NFANode(NFAEdgeType edgeType);
 
-        NFANode(const NFANode &node);
-
-        void inverseCharSet();
+        //该节点的边能否接受字符c
+        inline bool acceptChar(char c) const {
+            if (edgeType == NFAEdgeType::normalChar)
+                return edgeValue == c;
+            if (edgeType == NFAEdgeType::charCollection)
+                return edgeValue == '.' || edgeSet->contains(c);
+            return false;
+        }
     };
 
+    // NFA片段的头尾节点下标
     struct NFANodePair {
-        std::shared_ptr<NFANode> start;
-        std::shared_ptr<NFANode> end;
+        int start = -1;
+        int end = -1;
     };
 
     //非确定有限状态机
@@ -65,18 +78,26 @@ namespace zhRegex {
         friend class DFA;
 
     private:
-        Lexer lexer;
+        //所有NFA节点
+        std::vector<NFANode> nodes;
         // NFA头结点
-        std::shared_ptr<NFANode> head;
+        int head = -1;
+        //是否含有零宽断言
+        bool hasLook = false;
+
+        //新建一个节点并返回其下标
+        int newNode(NFAEdgeType edgeType = NFAEdgeType::eofEdge);
 
+        //空串
+        void emptyString(NFANodePair &pair);
         //单个字符
-        void singleChar(NFANodePair &pair);
+        void singleChar(NFANodePair &pair, char c);
         //任意字符即.
         void anyChar(NFANodePair &pair);
         //字符集
-        void charCollection(NFANodePair &pair);
-        //转义字符
-        void escapeChar(NFANodePair &pair);
+        void charCollection(NFANodePair &pair, const std::shared_ptr<const CharSet> &charSet);
+        //零宽断言
+        void lookAssertion(NFANodePair &pair, uint8_t assertion);
 
         //*闭包
         void kleeneClosure(NFANodePair &pair);
@@ -84,37 +105,66 @@ namespace zhRegex {
         void positiveClosure(NFANodePair &pair);
         //?闭包
         void questionClosure(NFANodePair &pair);
-        //{n,m}闭包
-        void repeatClosure(NFANodePair &pair);
-
-        //{n,m}闭包辅助函数,m = -2时表示不存在,m = -1时表示无限
-        void repeatClosureHelper(NFANodePair &pair, int n, int m);
-        void regexExpression(NFANodePair &pair);
-        void groupExpression(NFANodePair &pair);
-        void expression(NFANodePair &pair);
-        void factorConnect(NFANodePair &pair);
-        void factor(NFANodePair &pair);
-        void term(NFANodePair &pair);
-
-        // type是否可由构成factor
-        bool canFactor(RegExToken type);
-        // closure算法(见虎书P26)
-        static hashSet<NFANode *> closure(hashSet<NFANode *> &closureSet);
+        //{n,m}闭包辅助函数,m = -1时表示无限,pair的节点从begin开始连续存放,复制前按budget检查节点数
+        void repeatClosureHelper(NFANodePair &pair, int begin, int n, int m, const CompileBudget *budget);
+        //复制节点下标在[begin,end)中的片段
+        NFANodePair copyFragment(const NFANodePair &pair, int begin, int end);
+
+        //头尾相连
+        void connect(NFANodePair &pair, const NFANodePair &next);
+        //或
+        void alternate(NFANodePair &pair, const NFANodePair &other);
+
+        //由AST自底向上(非递归)构造NFA,budget不为空时检查节点数与耗时
+        void build(const RegexAST &ast, const CompileBudget *budget = nullptr);
+
+        // closure算法(见虎书P26),looks为当前位置满足的断言
+        hashSet<NFANode *> closure(hashSet<NFANode *> &closureSet, uint8_t looks = 0);
         // DFAedge算法(见虎书P27)
-        static hashSet<NFANode *> DFAedge(hashSet<NFANode *> &closureSet, char c);
+        hashSet<NFANode *> DFAedge(hashSet<NFANode *> &closureSet, char c);
+        //子集构造使用的closure,states为有序的节点下标
+        void closure(std::vector<uint32_t> &states, std::vector<uint32_t> &marks, uint32_t stamp,
+                     uint8_t looks = 0) const;
+        //下标集合版本的DFAedge,结果写入next(先清空),marks与stamp的含义同closure
+        void DFAedge(const std::vector<uint32_t> &states, char c, std::vector<uint32_t> &next,
+                     std::vector<uint32_t> &marks, uint32_t stamp) const;
+        //子集构造,得到的DFA尚未finalize,threads > 1时每层状态并行展开,budget不为空时检查状态数、字节数与耗时
+        DFA subsetConstruction(unsigned threads = 1, const CompileBudget *budget = nullptr);
+        //contains的实现,对每个匹配调用emit(偏移, 长度)
+        template <typename Emit>
+        void forEachMatch(std::string_view input, Emit &&emit);
 
     public:
-        explicit NFA(const char *pattern);
-        explicit NFA(std::string &pattern);
-        explicit NFA(std::string_view &pattern);
+        //节点数或耗时超出limits时抛出RegexException
+        explicit NFA(const char *pattern, unsigned flags = RegexFlags::none,
+                     const CompileLimits &limits = CompileLimits());
+        explicit NFA(std::string &pattern, unsigned flags = RegexFlags::none,
+                     const CompileLimits &limits = CompileLimits());
+        explicit NFA(std::string_view &pattern, unsigned flags = RegexFlags::none,
+                     const CompileLimits &limits = CompileLimits());
+        explicit NFA(const RegexAST &ast, const CompileBudget *budget = nullptr);
         ~NFA() override = default;
 
-        //获取DFA
-        DFA NFAToDFA();
+        //获取DFA,状态编号与threads无关
+        DFA NFAToDFA(unsigned threads = 1);
+        //NFA节点个数
+        inline int nodeCount() const {
+            return (int) nodes.size();
+        }
         //整个input字符串是否匹配pattern
         bool match(std::string_view &input) override;
+        // input是否存在匹配pattern的前缀
+        bool matchPrefix(std::string_view &input) override;
         //找出所有匹配的string
         std::vector<std::string_view> contains(std::string_view &input) override;
+        //找出所有匹配,直接写入out
+        void contains(std::string_view input, MatchBuffer &out, uint32_t patternId = 0) override;
+        // input中是否存在匹配,任一线程到达终态即返回
+        bool isMatchAnywhere(std::string_view input) override;
+        //contains找到的匹配个数
+        size_t count(std::string_view input) override;
+        //占用的内存字节数
+        size_t memoryUsage() const override;
     };
 }  // namespace zhRegex
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
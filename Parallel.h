@@ -0,0 +1,119 @@
+#ifndef _ZH_PARALLEL_H_
+#define _ZH_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zhRegex {
+    //常驻的工作线程,在一次编译的多次parallelEach之间复用,避免每层子集构造都创建与回收线程
+    //threads <= 1时不创建线程,parallelEach直接在调用线程中执行
+    class WorkerPool {
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        //当前任务,每发布一次generation加一,只有编号不超过participants的线程参与
+        const std::function<void(unsigned)> *job = nullptr;
+        uint64_t generation = 0;
+        unsigned participants = 0;
+        //尚未完成当前任务的线程数
+        unsigned running = 0;
+        bool stopping = false;
+
+        //工作线程worker(从1开始编号)的主循环
+        void loop(unsigned worker) {
+            uint64_t seen = 0;
+            for (;;) {
+                const std::function<void(unsigned)> *current;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stopping || generation != seen; });
+                    if (stopping)
+                        return;
+                    seen = generation;
+                    if (worker > participants)
+                        continue;
+                    current = job;
+                }
+                (*current)(worker);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--running == 0)
+                    done.notify_one();
+            }
+        }
+
+        //在调用线程(worker 0)与前count - 1个工作线程上各执行一次function,全部完成后返回
+        void run(unsigned count, const std::function<void(unsigned)> &function) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = &function;
+                participants = count - 1;
+                running = count - 1;
+                generation++;
+            }
+            wake.notify_all();
+            function(0);
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&] { return running == 0; });
+        }
+
+    public:
+        explicit WorkerPool(unsigned threads) {
+            for (unsigned worker = 1; worker < threads; worker++)
+                workers.emplace_back([this, worker] { loop(worker); });
+        }
+
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool &operator=(const WorkerPool &) = delete;
+
+        ~WorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto &t: workers) {
+                t.join();
+            }
+        }
+
+        //参与计算的线程数(含调用线程)
+        inline unsigned size() const {
+            return (unsigned) workers.size() + 1;
+        }
+
+        //动态分配的并行循环,对[0,count)中的每个下标调用function(worker, index),worker在[0,size())中
+        //各线程每次从共享计数器领取grain个下标,先做完的线程继续领取,耗时不均时也能保持负载均衡
+        //不足两份grain时在调用线程中直接执行,小的BFS层不必唤醒工作线程
+        template <typename Function>
+        void parallelEach(size_t count, size_t grain, Function &&function) {
+            size_t shares = std::min<size_t>(size(), count / grain);
+            if (shares <= 1) {
+                for (size_t i = 0; i < count; i++)
+                    function(0u, i);
+                return;
+            }
+            std::atomic<size_t> next{0};
+            std::function<void(unsigned)> work = [&](unsigned worker) {
+                for (;;) {
+                    size_t begin = next.fetch_add(grain, std::memory_order_relaxed);
+                    if (begin >= count)
+                        break;
+                    size_t end = std::min(count, begin + grain);
+                    for (size_t i = begin; i < end; i++)
+                        function(worker, i);
+                }
+            };
+            run((unsigned) shares, work);
+        }
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_PARALLEL_H_
@@ -0,0 +1,638 @@
+#include "Parser.h"
+
+#include <algorithm>
+#include <string>
+
+namespace zhRegex {
+    namespace {
+        //按字节运算的字符集
+        struct ByteClassOps {
+            using Set = CharSet;
+
+            static void addRange(Set &set, uint32_t lo, uint32_t hi) {
+                set.addRange((uint8_t) lo, (uint8_t) hi);
+            }
+
+            //加入ASCII字符集base,negated时加入其补集
+            static void addClass(Set &set, const CharSet &base, bool negated) {
+                set |= negated ? ~base : base;
+            }
+
+            static void addSet(Set &set, const Set &other) {
+                set |= other;
+            }
+
+            static void intersect(Set &set, const Set &other) {
+                set &= other;
+            }
+
+            static void negate(Set &set) {
+                set = ~set;
+            }
+
+            static void caseFold(Set &set) {
+                Parser::caseFoldSet(set);
+            }
+        };
+
+        //UTF-8模式下按码点区间运算的字符集,补集相对于全部合法码点
+        struct CodePointClassOps {
+            using Set = std::vector<CodePointRange>;
+
+            static void addRange(Set &set, uint32_t lo, uint32_t hi) {
+                set.emplace_back(lo, hi);
+            }
+
+            static void addClass(Set &set, const CharSet &base, bool negated) {
+                Set ranges;
+                base.forEachRange([&](uint8_t lo, uint8_t hi) { ranges.emplace_back(lo, hi); });
+                if (negated)
+                    Utf8::negate(ranges);
+                set.insert(set.end(), ranges.begin(), ranges.end());
+            }
+
+            static void addSet(Set &set, const Set &other) {
+                set.insert(set.end(), other.begin(), other.end());
+            }
+
+            // a && b即~(~a | ~b)
+            static void intersect(Set &set, Set other) {
+                negate(set);
+                negate(other);
+                addSet(set, other);
+                negate(set);
+            }
+
+            static void negate(Set &set) {
+                Utf8::normalize(set);
+                Utf8::negate(set);
+            }
+
+            static void caseFold(Set &set) {
+                Parser::caseFoldRanges(set);
+            }
+        };
+    }  // namespace
+
+    //构造函数
+    Parser::Parser(std::string_view &pattern, unsigned flags) : lexer(pattern), flags(flags) {}
+
+    //转义字符集(\d,\D,\w,\W,\s,\S)加入set
+    void Parser::escapeCharSet(char c, CharSet &set) {
+        set |= *CharSet::escape(c);
+    }
+
+    //转义字符集(\d,\D,\w,\W,\s,\S)对应的码点区间加入ranges,大写的转义为小写转义在全部码点上的补集
+    void Parser::escapeCharRanges(char c, std::vector<CodePointRange> &ranges) {
+        CodePointClassOps::addClass(ranges, *CharSet::escape((char) (c | 0x20)), c < 'a');
+    }
+
+    //把set中ASCII字母的另一种大小写也加入set
+    void Parser::caseFoldSet(CharSet &set) {
+        for (char c = 'a'; c <= 'z'; ++c) {
+            char upper = (char) (c - 'a' + 'A');
+            if (set.contains(c) || set.contains(upper)) {
+                set.add(c);
+                set.add(upper);
+            }
+        }
+    }
+
+    //区间与[a-z]、[A-Z]的交集平移到另一种大小写
+    void Parser::caseFoldRanges(std::vector<CodePointRange> &ranges) {
+        size_t count = ranges.size();
+        for (size_t i = 0; i < count; i++) {
+            CodePointRange range = ranges[i];
+            for (uint32_t lo : {(uint32_t) 'a', (uint32_t) 'A'}) {
+                uint32_t first = std::max(range.first, lo);
+                uint32_t last = std::min(range.second, lo + 25);
+                if (first > last)
+                    continue;
+                uint32_t other = lo == 'a' ? 'A' : 'a';
+                ranges.emplace_back(first - lo + other, last - lo + other);
+            }
+        }
+    }
+
+    //单个字符
+    int Parser::singleChar() {
+        int node = literal(lexer.getCurrentChar());
+        lexer.advance();
+        return node;
+    }
+
+    //字符c的节点
+    int Parser::literal(char c) {
+        char lower = (char) (c | 0x20);
+        if (!(flags & RegexFlags::caseInsensitive) || lower < 'a' || lower > 'z') {
+            int node = ast.addNode(ASTNodeType::singleChar);
+            ast[node].value = c;
+            return node;
+        }
+        std::shared_ptr<const CharSet> &charSet = caseSets[lower - 'a'];
+        if (charSet == nullptr)
+            charSet = std::make_shared<const CharSet>(CharSet::of(lower) | CharSet::of((char) (lower - 'a' + 'A')));
+        int node = ast.addNode(ASTNodeType::charCollection);
+        ast[node].charSet = charSet;
+        return node;
+    }
+
+    //.字符
+    int Parser::anyChar() {
+        int node = ast.addNode(ASTNodeType::anyChar);
+        lexer.advance();
+        return node;
+    }
+
+    //字符集
+    int Parser::charCollection() {
+        int node = ast.addNode(ASTNodeType::charCollection);
+        ast[node].charSet = CharSet::shared(classExpression<ByteClassOps>());
+        return node;
+    }
+
+    //字符集的内容,lexer停在[上,结束时停在最外层的]之后
+    //每层[...]是若干成员的并集,&&把一层分为若干部分求交集,开头的^对整层取反;[a-z&&[^aeiou]]即差集
+    //嵌套的层次放在显式的栈中,与括号的处理相同
+    template <typename Ops>
+    typename Ops::Set Parser::classExpression() {
+        using Set = typename Ops::Set;
+        //一层[...]
+        struct Level {
+            bool negated = false;
+            //&&左侧各部分的交集
+            bool hasLeft = false;
+            Set left;
+            //当前部分的并集
+            Set current;
+            //前一个可作为区间起点的字符
+            bool hasFirst = false;
+            uint32_t first = 0;
+        };
+        bool caseInsensitive = flags & RegexFlags::caseInsensitive;
+        std::vector<Level> levels;
+        auto open = [&]() {
+            //跳过[
+            lexer.advance();
+            levels.emplace_back();
+            if (lexer.match(RegExToken::CharBegin)) {
+                levels.back().negated = true;
+                lexer.advance();
+            }
+        };
+        //结束当前部分,先展开大小写再求交集,[a&&[A]]在忽略大小写时为[aA]
+        auto finishPart = [&](Level &level) {
+            if (caseInsensitive)
+                Ops::caseFold(level.current);
+            if (level.hasLeft) {
+                Ops::intersect(level.left, level.current);
+            } else {
+                level.left = std::move(level.current);
+                level.hasLeft = true;
+            }
+            level.current = Set();
+            level.hasFirst = false;
+        };
+        open();
+        while (true) {
+            Level &level = levels.back();
+            if (lexer.match(RegExToken::Eof))
+                throw RegexException();
+            if (lexer.match(RegExToken::RightCollection)) {
+                //跳过]
+                lexer.advance();
+                finishPart(level);
+                //先展开大小写再取反,[^a]不匹配A
+                Set result = std::move(level.left);
+                if (level.negated)
+                    Ops::negate(result);
+                levels.pop_back();
+                if (levels.empty())
+                    return result;
+                Ops::addSet(levels.back().current, result);
+                levels.back().hasFirst = false;
+                continue;
+            }
+            if (lexer.match(RegExToken::LeftCollection)) {
+                if (lexer.peek() == ':') {
+                    bool negated = false;
+                    const CharSet &base = posixClass(negated);
+                    Ops::addClass(level.current, base, negated);
+                    level.hasFirst = false;
+                } else {
+                    open();
+                }
+                continue;
+            }
+            if (lexer.match(RegExToken::SingleChar) && !lexer.isEscaped() && lexer.getCurrentChar() == '&' &&
+                lexer.peek() == '&') {
+                //跳过&&
+                lexer.advance();
+                lexer.advance();
+                finishPart(level);
+                continue;
+            }
+            if (lexer.match(RegExToken::EscapeChar)) {
+                char c = lexer.getCurrentChar();
+                Ops::addClass(level.current, *CharSet::escape((char) (c | 0x20)), c < 'a');
+                level.hasFirst = false;
+            } else if (lexer.match(RegExToken::Dash) && level.hasFirst) {
+                //破折号前有字符且后面不是]时表示区间,否则视为正常的-符号
+                lexer.advance();
+                if (lexer.match(RegExToken::RightCollection)) {
+                    Ops::addRange(level.current, '-', '-');
+                    level.hasFirst = false;
+                    continue;
+                }
+                if (lexer.match(RegExToken::Eof) || lexer.match(RegExToken::EscapeChar) ||
+                    lexer.match(RegExToken::LeftCollection))
+                    throw RegexException();
+                uint32_t last = classChar();
+                if (last < level.first)
+                    throw RegexException();
+                Ops::addRange(level.current, level.first, last);
+                level.hasFirst = false;
+            } else {
+                level.first = classChar();
+                Ops::addRange(level.current, level.first, level.first);
+                level.hasFirst = true;
+            }
+            lexer.advance();
+        }
+    }
+
+    //[:name:]或[:^name:],lexer停在[上,结束时停在]之后
+    const CharSet &Parser::posixClass(bool &negated) {
+        //跳过[:
+        lexer.advance();
+        lexer.advance();
+        negated = lexer.match(RegExToken::CharBegin);
+        if (negated)
+            lexer.advance();
+        std::string name;
+        while (lexer.match(RegExToken::SingleChar) && lexer.getCurrentChar() != ':') {
+            name += lexer.getCurrentChar();
+            lexer.advance();
+        }
+        if (!lexer.match(RegExToken::SingleChar))
+            throw RegexException();
+        lexer.advance();
+        if (!lexer.match(RegExToken::RightCollection))
+            throw RegexException();
+        lexer.advance();
+        const CharSet *set = CharSet::posix(name);
+        if (set == nullptr)
+            throw RegexException();
+        return *set;
+    }
+
+    //字符集中的一个字符,UTF-8模式下为完整的码点
+    uint32_t Parser::classChar() {
+        if (flags & RegexFlags::utf8)
+            return codePoint();
+        return (uint8_t) lexer.getCurrentChar();
+    }
+
+    //转义字符,转义字符集在展开大小写后不变,直接使用共享的字符集
+    int Parser::escapeChar() {
+        int node = ast.addNode(ASTNodeType::charCollection);
+        ast[node].charSet = CharSet::shared(*CharSet::escape(lexer.getCurrentChar()));
+        lexer.advance();
+        return node;
+    }
+
+    // term ::= char | "[" class "]" | escape | .
+    int Parser::term() {
+        if (flags & RegexFlags::utf8) {
+            switch (lexer.getCurrentToken()) {
+            case RegExToken::AnyChar:
+                lexer.advance();
+                return utf8Class({{0, Utf8::maxCodePoint}});
+            case RegExToken::LeftCollection:
+                return utf8CharCollection();
+            case RegExToken::EscapeChar: {
+                std::vector<CodePointRange> ranges;
+                escapeCharRanges(lexer.getCurrentChar(), ranges);
+                lexer.advance();
+                return utf8Class(std::move(ranges));
+            }
+            default:
+                return utf8Char();
+            }
+        }
+        switch (lexer.getCurrentToken()) {
+        case RegExToken::AnyChar:
+            return anyChar();
+        case RegExToken::LeftCollection:
+            return charCollection();
+        case RegExToken::EscapeChar:
+            return escapeChar();
+        default:
+            return singleChar();
+        }
+    }
+
+    //读取当前位置的一个完整码点,结束时lexer停在码点的最后一个字节上,\xHH为码点U+00HH
+    uint32_t Parser::codePoint() {
+        if (lexer.isHexEscape())
+            return (uint8_t) lexer.getCurrentChar();
+        uint8_t bytes[4];
+        bytes[0] = (uint8_t) lexer.getCurrentChar();
+        int length = Utf8::sequenceLength(bytes[0]);
+        if (length == 0)
+            throw RegexException();
+        for (int i = 1; i < length; i++) {
+            lexer.advance();
+            if (!lexer.match(RegExToken::SingleChar))
+                throw RegexException();
+            bytes[i] = (uint8_t) lexer.getCurrentChar();
+        }
+        int32_t value = Utf8::decode(bytes, length);
+        if (value < 0)
+            throw RegexException();
+        return (uint32_t) value;
+    }
+
+    //单个码点,多字节时为各字节的连接,闭包作用于整个码点
+    int Parser::utf8Char() {
+        uint8_t bytes[4];
+        int length = Utf8::encode(codePoint(), bytes);
+        lexer.advance();
+        std::vector<int> sequence;
+        //多字节码点的各字节都不是ASCII字母,只有单字节时才可能展开大小写
+        for (int i = 0; i < length; i++)
+            sequence.emplace_back(literal((char) bytes[i]));
+        return connect(sequence);
+    }
+
+    //字符集,成员与区间端点均为码点
+    int Parser::utf8CharCollection() {
+        return utf8Class(classExpression<CodePointClassOps>());
+    }
+
+    //字节区间[lo, hi],单个字节时为普通字符
+    int Parser::byteRange(Utf8ByteRange range) {
+        if (range.lo == range.hi) {
+            int node = ast.addNode(ASTNodeType::singleChar);
+            ast[node].value = (char) range.lo;
+            return node;
+        }
+        std::shared_ptr<const CharSet> &charSet = byteRangeSets[range.lo << 8 | range.hi];
+        if (charSet == nullptr)
+            charSet = std::make_shared<const CharSet>(CharSet::range(range.lo, range.hi));
+        int node = ast.addNode(ASTNodeType::charCollection);
+        ast[node].charSet = charSet;
+        return node;
+    }
+
+    //码点区间的并集
+    //拆分得到的序列按最后一个字节区间分组,同组的前缀合并后再连接该区间,对前缀重复此过程
+    //大多数序列以[80-BF]结尾,共享后缀后NFA与DFA都只需很少的状态
+    int Parser::utf8Class(std::vector<CodePointRange> ranges) {
+        Utf8::normalize(ranges);
+        if (ranges.empty() || ranges.back().second < 0x80) {
+            //纯ASCII时与普通字符集相同
+            CharSet charSet;
+            for (const CodePointRange &range : ranges)
+                charSet.addRange((uint8_t) range.first, (uint8_t) range.second);
+            int node = ast.addNode(ASTNodeType::charCollection);
+            ast[node].charSet = CharSet::shared(charSet);
+            return node;
+        }
+        std::vector<Utf8Sequence> sequences;
+        for (const CodePointRange &range : ranges)
+            Utf8::split(range, sequences);
+
+        //(待合并的序列, 合并结果所在的节点),序列最长为4个字节,工作量很小
+        struct Work {
+            std::vector<Utf8Sequence> sequences;
+            int node;
+        };
+        int root = ast.addNode(ASTNodeType::alternate);
+        std::vector<Work> works;
+        works.push_back({std::move(sequences), root});
+        while (!works.empty()) {
+            Work work = std::move(works.back());
+            works.pop_back();
+            //按最后一个字节区间分组,保持首次出现的顺序
+            std::vector<Utf8ByteRange> lasts;
+            std::vector<std::vector<Utf8Sequence>> groups;
+            std::vector<bool> hasEmpty;
+            for (Utf8Sequence &sequence : work.sequences) {
+                Utf8ByteRange last = sequence.back();
+                sequence.pop_back();
+                size_t k = std::find(lasts.begin(), lasts.end(), last) - lasts.begin();
+                if (k == lasts.size()) {
+                    lasts.push_back(last);
+                    groups.emplace_back();
+                    hasEmpty.push_back(false);
+                }
+                if (sequence.empty())
+                    hasEmpty[k] = true;
+                else
+                    groups[k].emplace_back(std::move(sequence));
+            }
+            std::vector<int> branches;
+            for (size_t k = 0; k < lasts.size(); k++) {
+                int tail = byteRange(lasts[k]);
+                if (groups[k].empty()) {
+                    branches.push_back(tail);
+                    continue;
+                }
+                //前缀稍后展开到prefix节点中
+                int prefix = ast.addNode(ASTNodeType::alternate);
+                int head = prefix;
+                if (hasEmpty[k]) {
+                    head = ast.addNode(ASTNodeType::repeat);
+                    ast[head].min = 0;
+                    ast[head].max = 1;
+                    ast[head].children.push_back(prefix);
+                }
+                int branch = ast.addNode(ASTNodeType::concat);
+                ast[branch].children = {head, tail};
+                branches.push_back(branch);
+                works.push_back({std::move(groups[k]), prefix});
+            }
+            if (branches.size() == 1) {
+                //只有一个分支时用group代替alternate
+                ast[work.node].type = ASTNodeType::group;
+            }
+            ast[work.node].children = std::move(branches);
+        }
+        return root;
+    }
+
+    //读取一个十进制数,超出size_t时取最大值,由repeatRange报告超出上限
+    size_t Parser::number() {
+        size_t n = 0;
+        while (lexer.match(RegExToken::SingleChar) && '0' <= lexer.getCurrentChar() && lexer.getCurrentChar() <= '9') {
+            size_t digit = lexer.getCurrentChar() - '0';
+            n = n > (SIZE_MAX - digit) / 10 ? SIZE_MAX : n * 10 + digit;
+            lexer.advance();
+        }
+        return n;
+    }
+
+    //解析{n,m},m = -1时表示无限
+    void Parser::repeatRange(int &n, int &m) {
+        //跳过{
+        lexer.advance();
+        size_t min = number();
+        //{n,}形式时max为无穷
+        bool unbounded = false;
+        size_t max = min;
+        if (lexer.match(RegExToken::RightBrace)) {
+            //{n}形式
+        } else if (lexer.match(RegExToken::SingleChar) && lexer.getCurrentChar() == ',') {
+            lexer.advance();
+            unbounded = lexer.match(RegExToken::RightBrace);
+            if (!unbounded)
+                max = number();
+            if (!lexer.match(RegExToken::RightBrace))
+                throw RegexException();
+        } else {
+            throw RegexException();
+        }
+        //跳过}
+        lexer.advance();
+        //先检查上限再转为int,避免溢出
+        size_t largest = unbounded ? min : std::max(min, max);
+        if (largest > maxRepeatCount)
+            throw RegexException(RegexErrorCode::repeatLimit, maxRepeatCount, largest);
+        if (!unbounded && min > max)
+            throw RegexException();
+        n = (int) min;
+        m = unbounded ? -1 : (int) max;
+    }
+
+    //为sequence的最后一个节点加上*,+,?,{n,m}闭包
+    void Parser::closure(std::vector<int> &sequence) {
+        //闭包符前必须有内容
+        if (sequence.empty())
+            throw RegexException();
+        int n = 0;
+        int m = 0;
+        switch (lexer.getCurrentToken()) {
+        case RegExToken::Kleene:
+            m = -1;
+            lexer.advance();
+            break;
+        case RegExToken::Positive:
+            n = 1;
+            m = -1;
+            lexer.advance();
+            break;
+        case RegExToken::Question:
+            m = 1;
+            lexer.advance();
+            break;
+        default:
+            repeatRange(n, m);
+            break;
+        }
+        int node = ast.addNode(ASTNodeType::repeat);
+        ast[node].min = n;
+        ast[node].max = m;
+        ast[node].children.emplace_back(sequence.back());
+        sequence.back() = node;
+    }
+
+    //零宽断言
+    int Parser::look(uint8_t assertion) {
+        int node = ast.addNode(ASTNodeType::look);
+        ast[node].value = (char) assertion;
+        lexer.advance();
+        return node;
+    }
+
+    //将sequence连接为一个节点
+    int Parser::connect(std::vector<int> &sequence) {
+        if (sequence.empty())
+            return ast.addNode(ASTNodeType::empty);
+        if (sequence.size() == 1)
+            return sequence[0];
+        int node = ast.addNode(ASTNodeType::concat);
+        ast[node].children = std::move(sequence);
+        return node;
+    }
+
+    //结束一层括号,返回其对应的节点
+    int Parser::finishFrame(Frame &frame) {
+        frame.branches.emplace_back(connect(frame.sequence));
+        if (frame.branches.size() == 1)
+            return frame.branches[0];
+        int node = ast.addNode(ASTNodeType::alternate);
+        ast[node].children = std::move(frame.branches);
+        return node;
+    }
+
+    //解析整个pattern
+    RegexAST Parser::parse() {
+        std::vector<Frame> frames(1);
+        lexer.advance();
+        while (!lexer.match(RegExToken::Eof)) {
+            Frame &frame = frames.back();
+            switch (lexer.getCurrentToken()) {
+            case RegExToken::LeftParen:
+                frames.emplace_back();
+                lexer.advance();
+                break;
+            case RegExToken::RightParen: {
+                //多余的右括号
+                if (frames.size() == 1)
+                    throw RegexException();
+                int child = finishFrame(frame);
+                int group = ast.addNode(ASTNodeType::group);
+                ast[group].children.emplace_back(child);
+                frames.pop_back();
+                frames.back().sequence.emplace_back(group);
+                lexer.advance();
+                break;
+            }
+            case RegExToken::Or:
+                frame.branches.emplace_back(connect(frame.sequence));
+                frame.sequence.clear();
+                lexer.advance();
+                break;
+            case RegExToken::Kleene:
+            case RegExToken::Positive:
+            case RegExToken::Question:
+                closure(frame.sequence);
+                break;
+            case RegExToken::LeftBrace:
+                //前面没有内容时{视为普通字符
+                if (frame.sequence.empty())
+                    frame.sequence.emplace_back(singleChar());
+                else
+                    closure(frame.sequence);
+                break;
+            case RegExToken::CharBegin:
+                frame.sequence.emplace_back(look(flags & RegexFlags::multiline ? Look::lineBegin : Look::textBegin));
+                break;
+            case RegExToken::CharEnd:
+                frame.sequence.emplace_back(look(flags & RegexFlags::multiline ? Look::lineEnd : Look::textEnd));
+                break;
+            case RegExToken::TextBegin:
+                frame.sequence.emplace_back(look(Look::textBegin));
+                break;
+            case RegExToken::TextEnd:
+                frame.sequence.emplace_back(look(Look::textEnd));
+                break;
+            case RegExToken::WordBoundary:
+                frame.sequence.emplace_back(look(Look::wordBoundary));
+                break;
+            case RegExToken::NotWordBoundary:
+                frame.sequence.emplace_back(look(Look::notWordBoundary));
+                break;
+            default:
+                frame.sequence.emplace_back(term());
+                break;
+            }
+        }
+        //缺少右括号
+        if (frames.size() != 1)
+            throw RegexException();
+        ast.root = finishFrame(frames[0]);
+        return std::move(ast);
+    }
+}  // namespace zhRegex
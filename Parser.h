@@ -0,0 +1,110 @@
+#ifndef _ZH_PARSER_H_
+#define _ZH_PARSER_H_
+
+#include <string_view>
+#include <vector>
+
+#include "Lexer.h"
+#include "Look.h"
+#include "RegexAST.h"
+#include "Utf8.h"
+
+namespace zhRegex {
+    //解析选项,可按位组合
+    struct RegexFlags {
+        static constexpr unsigned none = 0;
+        // pattern与输入均按UTF-8解释,.和字符集匹配完整的码点,非ASCII字符作为一个整体参与闭包
+        static constexpr unsigned utf8 = 1u << 0;
+        //多行模式,^和$匹配每一行的开头与结尾,否则只匹配整个文本的开头与结尾
+        static constexpr unsigned multiline = 1u << 1;
+        //忽略大小写(ASCII字母),编译时把字母展开为包含大小写的字符集,输入无需转换
+        static constexpr unsigned caseInsensitive = 1u << 2;
+    };
+
+    //语法分析器,将pattern一次扫描转为RegexAST
+    //使用显式的括号栈代替递归下降,因此嵌套再深也不会栈溢出
+    class Parser {
+    private:
+        //括号栈中的一层
+        struct Frame {
+            //已经结束的|分支
+            std::vector<int> branches;
+            //当前分支中依次连接的节点
+            std::vector<int> sequence;
+        };
+
+        Lexer lexer;
+        RegexAST ast;
+        unsigned flags;
+        //UTF-8模式下每个字节区间对应的字符集,相同区间共享一个字符集
+        hashMap<int, std::shared_ptr<const CharSet>> byteRangeSets;
+        //忽略大小写时每个字母对应的字符集{小写, 大写},同一字母共享一个字符集,字节等价类只需细分一次
+        std::shared_ptr<const CharSet> caseSets[26];
+
+        //单个字符
+        int singleChar();
+        //字符c的节点,忽略大小写且c为字母时为其大小写字符集
+        int literal(char c);
+        //任意字符即.
+        int anyChar();
+        //字符集
+        int charCollection();
+        //字符集的内容,支持嵌套的[...]、&&交集与[:name:],Ops决定按字节还是按码点区间运算
+        template <typename Ops>
+        typename Ops::Set classExpression();
+        //字符集中的[:name:],negated表示[:^name:]
+        const CharSet &posixClass(bool &negated);
+        //字符集中的一个字符或码点
+        uint32_t classChar();
+        //转义字符
+        int escapeChar();
+        // term ::= char | "[" class "]" | escape | .
+        int term();
+
+        //为sequence的最后一个节点加上*,+,?,{n,m}闭包
+        void closure(std::vector<int> &sequence);
+        //解析{n,m},m = -1时表示无限
+        void repeatRange(int &n, int &m);
+        //读取一个十进制数,超出size_t时取最大值
+        size_t number();
+
+        //UTF-8模式:读取当前位置的一个完整码点
+        uint32_t codePoint();
+        //UTF-8模式:单个码点,多字节时为各字节的连接
+        int utf8Char();
+        //UTF-8模式:字符集
+        int utf8CharCollection();
+        //UTF-8模式:码点区间的并集,拆分为字节区间序列后合并公共后缀
+        int utf8Class(std::vector<CodePointRange> ranges);
+        //字节区间[lo, hi]
+        int byteRange(Utf8ByteRange range);
+
+        //零宽断言
+        int look(uint8_t assertion);
+
+        //将sequence连接为一个节点
+        int connect(std::vector<int> &sequence);
+        //结束一层括号,返回其对应的节点
+        int finishFrame(Frame &frame);
+
+    public:
+        //{n,m}中n与m的上限,更大的次数无论NFA还是DFA都会展开出过多的节点,且可能溢出int
+        static constexpr size_t maxRepeatCount = 1000;
+
+        explicit Parser(std::string_view &pattern, unsigned flags = RegexFlags::none);
+
+        //解析整个pattern
+        RegexAST parse();
+
+        //转义字符集(\d,\D,\w,\W,\s,\S)加入set
+        static void escapeCharSet(char c, CharSet &set);
+        //转义字符集(\d,\D,\w,\W,\s,\S)对应的码点区间加入ranges
+        static void escapeCharRanges(char c, std::vector<CodePointRange> &ranges);
+        //把set中ASCII字母的另一种大小写也加入set
+        static void caseFoldSet(CharSet &set);
+        //把ranges中ASCII字母的另一种大小写也加入ranges
+        static void caseFoldRanges(std::vector<CodePointRange> &ranges);
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_PARSER_H_
@@ -1,17 +1,80 @@
 #ifndef _ZH_PATTERN_H_
 #define _ZH_PATTERN_H_
 
+#include <cstdint>
 #include <string_view>
 #include <vector>
 
+#include "MatchBuffer.h"
+#include "RegexStats.h"
+
 namespace zhRegex {
     class Pattern {
     public:
+#ifdef ZH_REGEX_STATS
+        //运行统计中的编号,-1表示不统计;编号属于对象本身,复制得到的对象不统计,移动时转交,析构时释放
+        int statsId = -1;
+
+        Pattern() = default;
+        Pattern(const Pattern &) {}
+        Pattern(Pattern &&other) noexcept : statsId(other.statsId) {
+            other.statsId = -1;
+        }
+        Pattern &operator=(const Pattern &) {
+            return *this;
+        }
+        Pattern &operator=(Pattern &&) noexcept {
+            return *this;
+        }
+
+        virtual ~Pattern() {
+            RegexStats::unregisterCompiled(statsId);
+        }
+#else
         virtual ~Pattern() = default;
+#endif
         //整个input字符串是否匹配pattern
         virtual bool match(std::string_view &input) = 0;
+        // input是否存在匹配pattern的前缀(含空前缀),找到第一个即返回
+        virtual bool matchPrefix(std::string_view &input) = 0;
         //找出所有匹配的string
         virtual std::vector<std::string_view> contains(std::string_view &input) = 0;
+        //找出所有匹配,以(偏移, 长度, patternId)追加到out,不清空out
+        virtual void contains(std::string_view input, MatchBuffer &out, uint32_t patternId = 0) {
+            std::string_view view = input;
+            for (std::string_view s: contains(view))
+                out.push(s.data() - input.data(), s.size(), patternId);
+        }
+        // input中是否存在匹配pattern的子串(含空串),找到第一个即返回
+        virtual bool isMatchAnywhere(std::string_view input) = 0;
+        //contains找到的匹配个数,不保存匹配结果
+        virtual size_t count(std::string_view input) {
+            std::string_view view = input;
+            return contains(view).size();
+        }
+        //占用的内存字节数
+        virtual size_t memoryUsage() const = 0;
+
+        //批量匹配,out[i]表示inputs[i]是否整体匹配pattern,lanes为交错推进的输入个数
+        virtual void matchBatch(const std::string_view *inputs, size_t count, uint8_t *out, int /*lanes*/) {
+            for (size_t i = 0; i < count; i++) {
+                std::string_view input = inputs[i];
+                out[i] = match(input);
+            }
+        }
+
+        //将input切分为chunks块同步推进后判断是否整体匹配,threads > 1时各块由多个线程处理
+        virtual bool matchChunked(std::string_view &input, int /*chunks*/, unsigned /*threads*/) {
+            return match(input);
+        }
+
+        //批量查找,out[i]为inputs[i]中所有匹配的string
+        virtual void containsBatch(const std::string_view *inputs, size_t count, std::vector<std::string_view> *out) {
+            for (size_t i = 0; i < count; i++) {
+                std::string_view input = inputs[i];
+                out[i] = contains(input);
+            }
+        }
     };
 }  // namespace zhRegex
 
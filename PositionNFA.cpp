@@ -0,0 +1,417 @@
+#include "PositionNFA.h"
+
+#include <algorithm>
+
+#include "DFA.h"
+#include "SubsetBuilder.h"
+
+namespace zhRegex {
+    // class PositionNFA
+    PositionNFA::PositionNFA(const char *pattern, unsigned flags, const CompileLimits &limits) {
+        ZH_STATS_COMPILE_BEGIN();
+        CompileBudget budget(limits);
+        std::string_view patternS = pattern;
+        Parser parser(patternS, flags);
+        RegexAST ast = parser.parse();
+        ASTOptimizer::optimize(ast);
+        build(std::move(ast), &budget);
+        ZH_STATS_COMPILE_END(pattern, "glushkov", stateCount());
+    }
+
+    PositionNFA::PositionNFA(std::string &pattern, unsigned flags, const CompileLimits &limits) {
+        ZH_STATS_COMPILE_BEGIN();
+        CompileBudget budget(limits);
+        std::string_view patternS = pattern;
+        Parser parser(patternS, flags);
+        RegexAST ast = parser.parse();
+        ASTOptimizer::optimize(ast);
+        build(std::move(ast), &budget);
+        ZH_STATS_COMPILE_END(pattern, "glushkov", stateCount());
+    }
+
+    PositionNFA::PositionNFA(std::string_view &pattern, unsigned flags, const CompileLimits &limits) {
+        ZH_STATS_COMPILE_BEGIN();
+        CompileBudget budget(limits);
+        Parser parser(pattern, flags);
+        RegexAST ast = parser.parse();
+        ASTOptimizer::optimize(ast);
+        build(std::move(ast), &budget);
+        ZH_STATS_COMPILE_END(pattern, "glushkov", stateCount());
+    }
+
+    //由AST直接构造,不做化简
+    PositionNFA::PositionNFA(const RegexAST &ast, const CompileBudget *budget) {
+        build(ast, budget);
+    }
+
+    //复制以root为根的子树,新节点追加在ast末尾
+    int PositionNFA::copySubtree(RegexAST &ast, int root) {
+        //先复制到局部变量,避免push_back扩容后引用失效
+        ASTNode rootCopy = ast[root];
+        ast.nodes.emplace_back(std::move(rootCopy));
+        int newRoot = (int) ast.nodes.size() - 1;
+        //栈中的新节点其children仍指向旧节点
+        std::vector<int> nodeStack{newRoot};
+        while (!nodeStack.empty()) {
+            int node = nodeStack.back();
+            nodeStack.pop_back();
+            std::vector<int> children = ast[node].children;
+            for (int &child : children) {
+                ASTNode childCopy = ast[child];
+                ast.nodes.emplace_back(std::move(childCopy));
+                child = (int) ast.nodes.size() - 1;
+                nodeStack.push_back(child);
+            }
+            ast[node].children = std::move(children);
+        }
+        return newRoot;
+    }
+
+    //将{n,m}闭包展开为*,+,?闭包的连接,展开方式与NFA::repeatClosureHelper相同
+    void PositionNFA::expandRepeats(RegexAST &ast, const CompileBudget *budget) {
+        //后序,子树中的{n,m}先展开,复制时不会再出现{n,m}
+        std::vector<int> order;
+        std::vector<std::pair<int, bool>> nodeStack{{ast.root, false}};
+        while (!nodeStack.empty()) {
+            auto [node, expanded] = nodeStack.back();
+            nodeStack.pop_back();
+            if (expanded) {
+                order.push_back(node);
+                continue;
+            }
+            nodeStack.emplace_back(node, true);
+            for (int child : ast[node].children)
+                nodeStack.emplace_back(child, false);
+        }
+        for (int node : order) {
+            if (ast[node].type != ASTNodeType::repeat)
+                continue;
+            int n = ast[node].min, m = ast[node].max;
+            if (m >= 0 && n > m) {
+                throw RegexException();
+            }
+            if ((n == 0 || n == 1) && (m == 1 || m == -1) && !(n == 1 && m == 1)) {
+                //*,+,?闭包无需展开
+                continue;
+            }
+            int child = ast[node].children[0];
+            if (n == 0 && m == 0) {
+                ast[node].type = ASTNodeType::empty;
+                ast[node].children.clear();
+                continue;
+            }
+            int count = m == -1 ? n : m;
+            std::vector<int> copies(count, child);
+            for (int i = 1; i < count; i++) {
+                copies[i] = copySubtree(ast, child);
+                if (budget != nullptr) {
+                    budget->checkNFANodes(ast.nodes.size());
+                    budget->checkTime();
+                }
+            }
+            for (int i = 0; i < count; i++) {
+                bool optional = i >= n;
+                bool repeated = m == -1 && i == n - 1;
+                if (!optional && !repeated)
+                    continue;
+                int wrapper = ast.addNode(ASTNodeType::repeat);
+                ast[wrapper].min = optional ? 0 : 1;
+                ast[wrapper].max = optional ? 1 : -1;
+                ast[wrapper].children.push_back(copies[i]);
+                copies[i] = wrapper;
+            }
+            ast[node].type = ASTNodeType::concat;
+            ast[node].children = std::move(copies);
+        }
+    }
+
+    //由AST计算first/last/follow集合(非递归)
+    void PositionNFA::build(RegexAST ast, const CompileBudget *budget) {
+        expandRepeats(ast, budget);
+        struct Info {
+            bool nullable = true;
+            std::vector<int> first;
+            std::vector<int> last;
+        };
+        std::vector<Info> infos(ast.nodes.size());
+        auto addFollow = [this](const std::vector<int> &from, const std::vector<int> &to) {
+            for (int p : from)
+                follow[p].insert(follow[p].end(), to.begin(), to.end());
+        };
+        auto newPosition = [this](Info &info, NFANode &&node) {
+            int p = (int) positions.size();
+            positions.emplace_back(std::move(node));
+            follow.emplace_back();
+            info.nullable = false;
+            info.first = {p};
+            info.last = {p};
+        };
+
+        std::vector<std::pair<int, bool>> astStack;
+        astStack.emplace_back(ast.root, false);
+        while (!astStack.empty()) {
+            auto [index, expanded] = astStack.back();
+            astStack.pop_back();
+            const ASTNode &astNode = ast[index];
+            if (!expanded) {
+                astStack.emplace_back(index, true);
+                //逆序入栈,使位置编号与pattern中的顺序一致
+                for (auto it = astNode.children.rbegin(); it != astNode.children.rend(); ++it) {
+                    astStack.emplace_back(*it, false);
+                }
+                continue;
+            }
+            Info &info = infos[index];
+            switch (astNode.type) {
+            case ASTNodeType::singleChar: {
+                NFANode node(NFAEdgeType::normalChar);
+                node.edgeValue = astNode.value;
+                newPosition(info, std::move(node));
+                break;
+            }
+            case ASTNodeType::anyChar: {
+                NFANode node(NFAEdgeType::charCollection);
+                node.edgeValue = '.';
+                newPosition(info, std::move(node));
+                break;
+            }
+            case ASTNodeType::charCollection: {
+                NFANode node;
+                node.edgeType = NFAEdgeType::charCollection;
+                node.edgeSet = astNode.charSet;
+                newPosition(info, std::move(node));
+                break;
+            }
+            case ASTNodeType::group:
+                info = std::move(infos[astNode.children[0]]);
+                break;
+            case ASTNodeType::concat:
+                for (int child : astNode.children) {
+                    Info &next = infos[child];
+                    addFollow(info.last, next.first);
+                    if (info.nullable)
+                        info.first.insert(info.first.end(), next.first.begin(), next.first.end());
+                    if (next.nullable)
+                        info.last.insert(info.last.end(), next.last.begin(), next.last.end());
+                    else
+                        info.last = std::move(next.last);
+                    info.nullable = info.nullable && next.nullable;
+                    next = Info();
+                }
+                break;
+            case ASTNodeType::alternate:
+                info.nullable = false;
+                for (int child : astNode.children) {
+                    Info &next = infos[child];
+                    info.nullable = info.nullable || next.nullable;
+                    info.first.insert(info.first.end(), next.first.begin(), next.first.end());
+                    info.last.insert(info.last.end(), next.last.begin(), next.last.end());
+                    next = Info();
+                }
+                break;
+            case ASTNodeType::repeat:
+                //此时只剩*,+,?闭包
+                info = std::move(infos[astNode.children[0]]);
+                if (astNode.max == -1)
+                    addFollow(info.last, info.first);
+                if (astNode.min == 0)
+                    info.nullable = true;
+                break;
+            case ASTNodeType::look:
+                //位置自动机的状态只记录位置,无法表示零宽断言,应使用Thompson构造
+                throw RegexException(RegexErrorCode::unsupported);
+            default:
+                //空串
+                break;
+            }
+        }
+
+        Info &rootInfo = infos[ast.root];
+        nullable = rootInfo.nullable;
+        first = std::move(rootInfo.first);
+        last.assign(positions.size(), false);
+        for (int p : rootInfo.last)
+            last[p] = true;
+        std::sort(first.begin(), first.end());
+        first.erase(std::unique(first.begin(), first.end()), first.end());
+        for (std::vector<int> &positionsAfter : follow) {
+            std::sort(positionsAfter.begin(), positionsAfter.end());
+            positionsAfter.erase(std::unique(positionsAfter.begin(), positionsAfter.end()), positionsAfter.end());
+        }
+    }
+
+    //状态集合states经过c能到达的状态集合
+    void PositionNFA::step(const std::vector<int> &states, char c, std::vector<int> &nextStates) const {
+        nextStates.clear();
+        for (int state : states) {
+            //状态0之后为first,状态p + 1之后为follow[p]
+            const std::vector<int> &candidates = state == 0 ? first : follow[state - 1];
+            for (int p : candidates) {
+                if (positions[p].acceptChar(c))
+                    nextStates.push_back(p + 1);
+            }
+        }
+        std::sort(nextStates.begin(), nextStates.end());
+        nextStates.erase(std::unique(nextStates.begin(), nextStates.end()), nextStates.end());
+    }
+
+    //状态集合中是否存在终态
+    bool PositionNFA::isFinal(const std::vector<int> &states) const {
+        for (int state : states) {
+            if (state == 0 ? nullable : last[state - 1])
+                return true;
+        }
+        return false;
+    }
+
+    //子集构造,与NFA::subsetConstruction相同,但状态集合无需求闭包
+    DFA PositionNFA::subsetConstruction(unsigned threads, const CompileBudget *budget) {
+        std::vector<const NFANode *> edges;
+        for (const NFANode &position : positions)
+            edges.push_back(&position);
+        ByteClasses classes(edges);
+        std::vector<std::vector<uint16_t>> positionClasses(positions.size());
+        for (size_t p = 0; p < positions.size(); p++) {
+            classes.acceptedClasses(positions[p], positionClasses[p]);
+        }
+
+        //每个线程的临时空间
+        struct Scratch {
+            std::vector<std::vector<uint32_t>> buckets;
+            std::vector<int> touched;
+        };
+        threads = std::max(threads, 1u);
+        std::vector<Scratch> scratches(threads);
+        for (Scratch &scratch : scratches)
+            scratch.buckets.resize(classes.count());
+        auto expand = [&](unsigned worker, const std::vector<uint32_t> &states, SubsetSuccessors &successors,
+                          std::vector<int> &) {
+            Scratch &scratch = scratches[worker];
+            for (uint32_t state : states) {
+                //状态0之后为first,状态p + 1之后为follow[p]
+                for (int p : state == 0 ? first : follow[state - 1]) {
+                    for (uint16_t cls : positionClasses[p]) {
+                        if (scratch.buckets[cls].empty())
+                            scratch.touched.push_back(cls);
+                        scratch.buckets[cls].push_back((uint32_t) p + 1);
+                    }
+                }
+            }
+            std::sort(scratch.touched.begin(), scratch.touched.end());
+            for (int cls : scratch.touched) {
+                std::vector<uint32_t> &nextStatus = scratch.buckets[cls];
+                std::sort(nextStatus.begin(), nextStatus.end());
+                nextStatus.erase(std::unique(nextStatus.begin(), nextStatus.end()), nextStatus.end());
+                successors.emplace_back(cls, nextStatus);
+                nextStatus.clear();
+            }
+            scratch.touched.clear();
+        };
+        auto isFinalStatus = [this](const std::vector<uint32_t> &states) {
+            for (uint32_t state : states) {
+                if (state == 0 ? nullable : last[state - 1])
+                    return true;
+            }
+            return false;
+        };
+
+        DFA dfa;
+        buildSubsets(classes, {{0}}, threads, expand, isFinalStatus, dfa.table, dfa.statusMap, nullptr, budget);
+        return dfa;
+    }
+
+    //获取DFA
+    DFA PositionNFA::NFAToDFA(unsigned threads) {
+        DFA dfa = subsetConstruction(threads);
+        dfa.finalize();
+        return dfa;
+    }
+
+    //整个input字符串是否匹配pattern
+    bool PositionNFA::match(std::string_view &input) {
+        std::vector<int> states{0};
+        std::vector<int> nextStates;
+        for (char c : input) {
+            step(states, c, nextStates);
+            if (nextStates.empty())
+                return false;
+            states.swap(nextStates);
+        }
+        return isFinal(states);
+    }
+
+    // input是否存在匹配pattern的前缀
+    bool PositionNFA::matchPrefix(std::string_view &input) {
+        std::vector<int> states{0};
+        std::vector<int> nextStates;
+        for (char c : input) {
+            if (isFinal(states))
+                return true;
+            step(states, c, nextStates);
+            if (nextStates.empty())
+                return false;
+            states.swap(nextStates);
+        }
+        return isFinal(states);
+    }
+
+    // input中是否存在匹配
+    bool PositionNFA::isMatchAnywhere(std::string_view input) {
+        std::vector<int> states{0};
+        std::vector<int> nextStates;
+        for (char c : input) {
+            if (isFinal(states))
+                return true;
+            step(states, c, nextStates);
+            //后继都是位置(编号大于0),并入状态0表示在下一个位置重新开始,集合仍然有序
+            nextStates.insert(nextStates.begin(), 0);
+            states.swap(nextStates);
+        }
+        return isFinal(states);
+    }
+
+    //找出所有匹配的string,匹配规则与NFA::contains相同
+    std::vector<std::string_view> PositionNFA::contains(std::string_view &input) {
+        std::vector<std::string_view> ans;
+        int len = (int) input.size();
+        const std::vector<int> startStates{0};
+        std::vector<int> states = startStates;
+        std::vector<int> nextStates;
+        int index = 0;
+        for (int i = 0; i < len; i++) {
+            step(states, input[i], nextStates);
+            if (nextStates.empty()) {
+                //转移失败,若当前存在终态则记录匹配,之后重置为初始状态
+                if (isFinal(states))
+                    ans.emplace_back(input.substr(index, i - index));
+                index = i;
+                states = startStates;
+                step(states, input[i], nextStates);
+            }
+            if (!nextStates.empty())
+                states.swap(nextStates);
+            else
+                index = i + 1;
+        }
+        //最末尾情况
+        if (isFinal(states))
+            ans.emplace_back(input.substr(index, len - index + 1));
+        return ans;
+    }
+
+    //占用的内存字节数
+    size_t PositionNFA::memoryUsage() const {
+        size_t bytes = sizeof(PositionNFA) + positions.capacity() * sizeof(NFANode)
+                       + first.capacity() * sizeof(int) + last.capacity() / 8
+                       + follow.capacity() * sizeof(std::vector<int>);
+        for (const std::vector<int> &positionsAfter : follow)
+            bytes += positionsAfter.capacity() * sizeof(int);
+        //字符集可能被多个位置共享,只统计一次
+        hashSet<const CharSet *> charSets;
+        for (const NFANode &node : positions) {
+            if (node.edgeSet != nullptr && charSets.emplace(node.edgeSet.get()).second)
+                bytes += sizeof(CharSet);
+        }
+        return bytes;
+    }
+}  // namespace zhRegex
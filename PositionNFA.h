@@ -0,0 +1,82 @@
+#ifndef _ZH_POSITION_NFA_H_
+#define _ZH_POSITION_NFA_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "NFA.h"
+
+namespace zhRegex {
+    // NFA的构造方式
+    enum class NFAConstruction {
+        thompson,  // Thompson构造,每个运算符约产生2个epslion节点
+        glushkov   // Glushkov(位置自动机)构造,没有epslion边
+    };
+
+    //位置自动机(Glushkov自动机)
+    //pattern中的每个字符/字符集/.为一个位置,m个位置对应m + 1个状态:
+    //状态0为初始状态,状态p + 1表示刚读过位置p.由first/last/follow集合直接得到转移,不存在epslion边
+    class PositionNFA : public Pattern {
+        //友元DFA
+        friend class DFA;
+
+    private:
+        //每个位置的边,只使用edgeType/edgeValue/edgeSet
+        std::vector<NFANode> positions;
+        //可作为开头的位置
+        std::vector<int> first;
+        //位置p之后可以紧跟的位置
+        std::vector<std::vector<int>> follow;
+        //位置p是否可作为结尾
+        std::vector<bool> last;
+        //是否可以匹配空串
+        bool nullable = false;
+
+        //将{n,m}闭包展开为*,+,?闭包的连接,budget不为空时每复制一棵子树检查AST节点数
+        static void expandRepeats(RegexAST &ast, const CompileBudget *budget);
+        //复制以root为根的子树,返回新的根
+        static int copySubtree(RegexAST &ast, int root);
+        //由AST计算first/last/follow集合
+        void build(RegexAST ast, const CompileBudget *budget = nullptr);
+
+        //状态集合states经过c能到达的状态集合(有序且无重复)
+        void step(const std::vector<int> &states, char c, std::vector<int> &nextStates) const;
+        //状态集合中是否存在终态
+        bool isFinal(const std::vector<int> &states) const;
+        //子集构造,得到的DFA尚未finalize,threads > 1时每层状态并行展开,budget不为空时检查状态数、字节数与耗时
+        DFA subsetConstruction(unsigned threads = 1, const CompileBudget *budget = nullptr);
+
+    public:
+        //展开后的AST节点数或耗时超出limits时抛出RegexException
+        explicit PositionNFA(const char *pattern, unsigned flags = RegexFlags::none,
+                             const CompileLimits &limits = CompileLimits());
+        explicit PositionNFA(std::string &pattern, unsigned flags = RegexFlags::none,
+                             const CompileLimits &limits = CompileLimits());
+        explicit PositionNFA(std::string_view &pattern, unsigned flags = RegexFlags::none,
+                             const CompileLimits &limits = CompileLimits());
+        explicit PositionNFA(const RegexAST &ast, const CompileBudget *budget = nullptr);
+        ~PositionNFA() override = default;
+
+        //获取DFA,状态编号与threads无关
+        DFA NFAToDFA(unsigned threads = 1);
+        //状态个数,即位置个数 + 1
+        inline int stateCount() const {
+            return (int) positions.size() + 1;
+        }
+
+        //整个input字符串是否匹配pattern
+        bool match(std::string_view &input) override;
+        // input是否存在匹配pattern的前缀
+        bool matchPrefix(std::string_view &input) override;
+        //找出所有匹配的string
+        std::vector<std::string_view> contains(std::string_view &input) override;
+        using Pattern::contains;
+        // input中是否存在匹配,每个位置都把状态0并入当前集合
+        bool isMatchAnywhere(std::string_view input) override;
+        //占用的内存字节数
+        size_t memoryUsage() const override;
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_POSITION_NFA_H_
@@ -1,11 +1,49 @@
 #include "Regex.h"
 
+#include <algorithm>
+#include <thread>
+
 namespace zhRegex {
+    //每个线程至少处理的输入个数,过少时多线程得不偿失
+    static constexpr size_t minInputsPerThread = 4096;
+
+    //将[0,count)切分给至多threads个线程执行
+    template <typename Function>
+    static void parallelFor(size_t count, unsigned threads, Function &&function) {
+        size_t workers = std::min<size_t>(threads, count / minInputsPerThread);
+        if (workers <= 1) {
+            function(0, count);
+            return;
+        }
+        std::vector<std::thread> pool;
+        size_t step = (count + workers - 1) / workers;
+        for (size_t begin = step; begin < count; begin += step) {
+            pool.emplace_back(function, begin, std::min(count, begin + step));
+        }
+        function(0, step);
+        for (auto &t: pool) {
+            t.join();
+        }
+    }
+
     //构造函数
     Regex::Regex(Pattern *pattern) {
         this->pattern = pattern;
     }
 
+    //编译pattern,DFA超出限制时退回NFA
+    std::unique_ptr<Pattern> Regex::compile(std::string_view pattern, const CompileLimits &limits, unsigned flags,
+                                            unsigned threads) {
+        try {
+            return std::make_unique<DFA>(pattern, true, NFAConstruction::thompson, threads, flags, limits);
+        } catch (const RegexException &e) {
+            if (e.code == RegexErrorCode::syntax || e.code == RegexErrorCode::unsupported
+                || e.code == RegexErrorCode::repeatLimit || e.code == RegexErrorCode::nfaNodeLimit)
+                throw;
+        }
+        return std::make_unique<NFA>(pattern, flags, limits);
+    }
+
     Regex::~Regex() {
         this->pattern = nullptr;
     }
@@ -13,16 +51,37 @@ namespace zhRegex {
     //整个input字符串是否匹配pattern
     bool Regex::match(const char *input) {
         std::string_view inputS = input;
-        return pattern->match(inputS);
+        return match(inputS);
     }
     //整个input字符串是否匹配pattern
     bool Regex::match(std::string &input) {
         std::string_view inputS = input;
-        return pattern->match(inputS);
+        return match(inputS);
     }
     //整个input字符串是否匹配pattern
     bool Regex::match(std::string_view &input) {
-        return pattern->match(input);
+        ZH_STATS_CALL(pattern->statsId, StatCounter::matchCalls, 1, input.size());
+        bool matched = pattern->match(input);
+        ZH_STATS_FOUND(matched);
+        return matched;
+    }
+
+    // input是否存在匹配pattern的前缀
+    bool Regex::matchPrefix(const char *input) {
+        std::string_view inputS = input;
+        return matchPrefix(inputS);
+    }
+    // input是否存在匹配pattern的前缀
+    bool Regex::matchPrefix(std::string &input) {
+        std::string_view inputS = input;
+        return matchPrefix(inputS);
+    }
+    // input是否存在匹配pattern的前缀
+    bool Regex::matchPrefix(std::string_view &input) {
+        ZH_STATS_CALL(pattern->statsId, StatCounter::prefixCalls, 1, input.size());
+        bool matched = pattern->matchPrefix(input);
+        ZH_STATS_FOUND(matched);
+        return matched;
     }
 
     //找出所有匹配的string
@@ -33,10 +92,99 @@ namespace zhRegex {
     //找出所有匹配的string
     std::vector<std::string_view> Regex::contains(std::string &input) {
         std::string_view inputS = input;
-        return pattern->contains(inputS);
+        return contains(inputS);
     }
     //找出所有匹配的string
     std::vector<std::string_view> Regex::contains(std::string_view &input) {
-        return pattern->contains(input);
+        ZH_STATS_CALL(pattern->statsId, StatCounter::containsCalls, 1, input.size());
+        std::vector<std::string_view> ans = pattern->contains(input);
+        ZH_STATS_FOUND(ans.size());
+        return ans;
+    }
+    //找出所有匹配,写入out
+    void Regex::contains(std::string_view input, MatchBuffer &out, uint32_t patternId) {
+        ZH_STATS_CALL(pattern->statsId, StatCounter::containsCalls, 1, input.size());
+        ZH_STATS_ONLY(size_t before = out.size());
+        pattern->contains(input, out, patternId);
+        ZH_STATS_FOUND(out.size() - before);
+    }
+
+    // input中是否存在匹配
+    bool Regex::isMatchAnywhere(std::string_view input) {
+        ZH_STATS_CALL(pattern->statsId, StatCounter::anywhereCalls, 1, input.size());
+        bool matched = pattern->isMatchAnywhere(input);
+        ZH_STATS_FOUND(matched);
+        return matched;
+    }
+
+    //contains找到的匹配个数
+    size_t Regex::count(std::string_view input) {
+        ZH_STATS_CALL(pattern->statsId, StatCounter::countCalls, 1, input.size());
+        size_t matches = pattern->count(input);
+        ZH_STATS_FOUND(matches);
+        return matches;
+    }
+
+    //批量匹配
+    void Regex::matchBatch(const std::string_view *inputs, size_t count, uint8_t *out,
+                           unsigned threads, int lanes) {
+        parallelFor(count, threads, [&](size_t begin, size_t end) {
+            pattern->matchBatch(inputs + begin, end - begin, out + begin, lanes);
+#ifdef ZH_REGEX_STATS
+            size_t bytes = 0, matches = 0;
+            for (size_t i = begin; i < end; i++) {
+                bytes += inputs[i].size();
+                matches += out[i];
+            }
+            ZH_STATS_CALL(pattern->statsId, StatCounter::batchInputs, end - begin, bytes);
+            ZH_STATS_FOUND(matches);
+#endif
+        });
+    }
+
+    //批量匹配
+    std::vector<uint8_t> Regex::matchBatch(const std::vector<std::string_view> &inputs,
+                                           unsigned threads, int lanes) {
+        std::vector<uint8_t> out(inputs.size());
+        matchBatch(inputs.data(), inputs.size(), out.data(), threads, lanes);
+        return out;
+    }
+
+    //分块匹配
+    bool Regex::matchChunked(std::string_view &input, int chunks, unsigned threads) {
+        ZH_STATS_CALL(pattern->statsId, StatCounter::matchCalls, 1, input.size());
+        bool matched = pattern->matchChunked(input, chunks, threads);
+        ZH_STATS_FOUND(matched);
+        return matched;
+    }
+
+    //批量查找
+    void Regex::containsBatch(const std::string_view *inputs, size_t count,
+                              std::vector<std::string_view> *out, unsigned threads) {
+        parallelFor(count, threads, [&](size_t begin, size_t end) {
+            pattern->containsBatch(inputs + begin, end - begin, out + begin);
+#ifdef ZH_REGEX_STATS
+            size_t bytes = 0, matches = 0;
+            for (size_t i = begin; i < end; i++) {
+                bytes += inputs[i].size();
+                matches += out[i].size();
+            }
+            ZH_STATS_CALL(pattern->statsId, StatCounter::batchInputs, end - begin, bytes);
+            ZH_STATS_FOUND(matches);
+#endif
+        });
+    }
+
+    //批量查找
+    std::vector<std::vector<std::string_view>> Regex::containsBatch(const std::vector<std::string_view> &inputs,
+                                                                    unsigned threads) {
+        std::vector<std::vector<std::string_view>> out(inputs.size());
+        containsBatch(inputs.data(), inputs.size(), out.data(), threads);
+        return out;
+    }
+
+    //pattern占用的内存字节数
+    size_t Regex::memoryUsage() const {
+        return pattern->memoryUsage();
     }
-}  // namespace zhRegex
\ No newline at end of file
+}  // namespace zhRegex
\ No newline at end of file
@@ -1,8 +1,10 @@
 #ifndef _ZH_REGEX_H_
 #define _ZH_REGEX_H_
 
+#include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "DFA.h"
 
@@ -15,6 +17,11 @@ namespace zhRegex {
     public:
         explicit Regex(Pattern *pattern);
 
+        //编译pattern,优先构造最小DFA;DFA的状态数、字节数或耗时超出limits时退回NFA模拟,匹配结果相同,只是更慢
+        //pattern非法或NFA本身超出limits时抛出RegexException
+        static std::unique_ptr<Pattern> compile(std::string_view pattern, const CompileLimits &limits,
+                                                unsigned flags = RegexFlags::none, unsigned threads = 1);
+
         ~Regex();
 
         //整个input字符串是否匹配pattern
@@ -24,12 +31,48 @@ namespace zhRegex {
         //整个input字符串是否匹配pattern
         bool match(std::string_view &input);
 
+        // input是否存在匹配pattern的前缀,用于"以X开头"一类的校验,无需扫描整个input
+        bool matchPrefix(const char *input);
+        // input是否存在匹配pattern的前缀
+        bool matchPrefix(std::string &input);
+        // input是否存在匹配pattern的前缀
+        bool matchPrefix(std::string_view &input);
+
         //找出所有匹配的string
         std::vector<std::string_view> contains(const char *input);
         //找出所有匹配的string
         std::vector<std::string_view> contains(std::string &input);
         //找出所有匹配的string
         std::vector<std::string_view> contains(std::string_view &input);
+        //找出所有匹配,以(偏移, 长度, patternId)追加到out;out在多次调用间复用时不再分配内存
+        void contains(std::string_view input, MatchBuffer &out, uint32_t patternId = 0);
+
+        // input中是否存在匹配pattern的子串,只需判断有无时比contains快:找到第一个即返回,
+        //DFA还会先检查每个匹配都必须包含的字节,input中没有时直接返回false
+        bool isMatchAnywhere(std::string_view input);
+        //contains找到的匹配个数,不保存匹配结果
+        size_t count(std::string_view input);
+
+        //批量匹配,out[i]表示inputs[i]是否整体匹配pattern
+        //threads > 1且输入足够多时使用多线程,每个线程内lanes个输入交错推进
+        void matchBatch(const std::string_view *inputs, size_t count, uint8_t *out,
+                        unsigned threads = 1, int lanes = 4);
+        //批量匹配
+        std::vector<uint8_t> matchBatch(const std::vector<std::string_view> &inputs,
+                                        unsigned threads = 1, int lanes = 4);
+
+        //将input切分为chunks块同步推进后判断是否整体匹配,threads > 1时各块由多个线程处理
+        bool matchChunked(std::string_view &input, int chunks, unsigned threads = 1);
+
+        //批量查找,out[i]为inputs[i]中所有匹配的string
+        void containsBatch(const std::string_view *inputs, size_t count,
+                           std::vector<std::string_view> *out, unsigned threads = 1);
+        //批量查找
+        std::vector<std::vector<std::string_view>> containsBatch(const std::vector<std::string_view> &inputs,
+                                                                 unsigned threads = 1);
+
+        //pattern占用的内存字节数
+        size_t memoryUsage() const;
     };
 }  // namespace zhRegex
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef _ZH_REGEX_AST_H_
+#define _ZH_REGEX_AST_H_
+
+#include <memory>
+#include <vector>
+
+#include "CharSet.h"
+#include "Token.h"
+
+namespace zhRegex {
+    // AST节点类型
+    enum class ASTNodeType {
+        empty,           //空串
+        singleChar,      //单个字符
+        charCollection,  //字符集
+        anyChar,         //任意字符,.
+        concat,          //连接
+        alternate,       //或
+        repeat,          //闭包,*,+,?,{n,m}
+        group,           //括号
+        look             //零宽断言,^,$,\b,\B,\A,\z
+    };
+
+    // AST节点,子节点以下标形式存放在RegexAST中
+    struct ASTNode {
+        ASTNodeType type;
+        //singleChar的字符,look的断言(Look::textBegin等)
+        char value = '\0';
+        //charCollection的字符集
+        std::shared_ptr<const CharSet> charSet;
+        //repeat的次数,max = -1时表示无限
+        int min = 0;
+        int max = 0;
+        std::vector<int> children;
+
+        explicit ASTNode(ASTNodeType type) : type(type) {}
+    };
+
+    //正则表达式的抽象语法树,所有节点连续存放以减少分配
+    struct RegexAST {
+        std::vector<ASTNode> nodes;
+        int root = -1;
+
+        //新增一个节点并返回其下标
+        inline int addNode(ASTNodeType type) {
+            nodes.emplace_back(type);
+            return (int) nodes.size() - 1;
+        }
+
+        inline ASTNode &operator[](int index) {
+            return nodes[index];
+        }
+
+        inline const ASTNode &operator[](int index) const {
+            return nodes[index];
+        }
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_REGEX_AST_H_
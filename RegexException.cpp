@@ -1,7 +1,35 @@
 #include "RegexException.h"
 
 namespace zhRegex {
+    RegexException::RegexException(RegexErrorCode code, size_t limit, size_t actual)
+            : code(code), limit(limit), actual(actual) {
+        switch (code) {
+        case RegexErrorCode::syntax:
+            message = "Regular Expression Exception!";
+            return;
+        case RegexErrorCode::unsupported:
+            message = "Regular Expression Exception: unsupported by this construction";
+            return;
+        case RegexErrorCode::repeatLimit:
+            message = "Regular Expression Exception: repeat count limit ";
+            break;
+        case RegexErrorCode::nfaNodeLimit:
+            message = "Regular Expression Exception: NFA node limit ";
+            break;
+        case RegexErrorCode::dfaStateLimit:
+            message = "Regular Expression Exception: DFA state limit ";
+            break;
+        case RegexErrorCode::dfaMemoryLimit:
+            message = "Regular Expression Exception: DFA memory limit ";
+            break;
+        case RegexErrorCode::timeLimit:
+            message = "Regular Expression Exception: compile time limit (ms) ";
+            break;
+        }
+        message += std::to_string(limit) + " exceeded (" + std::to_string(actual) + ")";
+    }
+
     const char* RegexException::what() const noexcept {
-        return "Regular Expression Exception!";
+        return message.empty() ? "Regular Expression Exception!" : message.c_str();
     }
-}  // namespace zhRegex
\ No newline at end of file
+}  // namespace zhRegex
@@ -1,11 +1,40 @@
 #ifndef _ZH_REGEX_EXCEPTION_H_
 #define _ZH_REGEX_EXCEPTION_H_
 
+#include <cstddef>
 #include <exception>
+#include <string>
 
 namespace zhRegex {
+    //错误种类
+    enum class RegexErrorCode {
+        syntax,          //pattern语法错误
+        unsupported,     //所选的构造方式不支持该pattern
+        repeatLimit,     //{n,m}的次数超出Parser::maxRepeatCount
+        nfaNodeLimit,    //NFA节点数超出限制
+        dfaStateLimit,   //DFA状态数超出限制
+        dfaMemoryLimit,  //DFA占用的字节数超出限制
+        timeLimit        //编译耗时超出限制
+    };
+
     struct RegexException : public std::exception {
+        RegexErrorCode code = RegexErrorCode::syntax;
+        //超出的限制及实际值,只对*Limit错误有意义(timeLimit时单位为毫秒)
+        size_t limit = 0;
+        size_t actual = 0;
+
+        RegexException() = default;
+        RegexException(RegexErrorCode code, size_t limit = 0, size_t actual = 0);
+
+        //是否为资源限制导致的错误,此时pattern本身是合法的
+        inline bool isLimit() const {
+            return code >= RegexErrorCode::nfaNodeLimit;
+        }
+
         [[nodiscard]] const char* what() const noexcept override;
+
+    private:
+        std::string message;
     };
 }  // namespace zhRegex
 #endif  // !_REGEX_EXCEPTION_H_
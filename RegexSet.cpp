@@ -0,0 +1,209 @@
+#include "RegexSet.h"
+
+#include <algorithm>
+
+namespace zhRegex {
+    RegexSet::RegexSet(size_t shardSize, unsigned threads)
+            : current(std::make_shared<const Snapshot>()), shardSize(std::max<size_t>(shardSize, 1)),
+              threads(threads) {}
+
+    //由ids/patterns/dfas编译一个新的分片
+    std::shared_ptr<const RegexSet::Shard> RegexSet::buildShard(std::vector<int> ids, std::vector<std::string> patterns,
+                                                                std::vector<std::shared_ptr<DFA>> dfas) const {
+        auto shard = std::make_shared<Shard>();
+        if (dfas.size() == 1) {
+            //只有一个pattern时合并DFA即为其自身
+            shard->unionDFA = dfas[0];
+        } else {
+            std::string unionPattern;
+            for (const std::string &pattern : patterns) {
+                if (!unionPattern.empty())
+                    unionPattern += '|';
+                unionPattern += '(';
+                unionPattern += pattern;
+                unionPattern += ')';
+            }
+            shard->unionDFA = std::make_shared<DFA>(unionPattern, true, NFAConstruction::thompson, threads);
+        }
+        shard->ids = std::move(ids);
+        shard->patterns = std::move(patterns);
+        shard->dfas = std::move(dfas);
+        return shard;
+    }
+
+    //增删pattern,只重新编译受影响的分片
+    std::vector<int> RegexSet::update(const std::vector<std::string> &adds, const std::vector<int> &removes,
+                                      size_t *removed) {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        //先编译新pattern,非法时直接抛出,集合保持不变
+        std::vector<std::shared_ptr<DFA>> addDFAs;
+        for (const std::string &pattern : adds) {
+            std::string patternS = pattern;
+            addDFAs.push_back(std::make_shared<DFA>(patternS, true, NFAConstruction::thompson, threads));
+        }
+
+        //待重新编译的分片
+        struct Draft {
+            bool dirty = false;
+            std::vector<int> ids;
+            std::vector<std::string> patterns;
+            std::vector<std::shared_ptr<DFA>> dfas;
+        };
+        std::shared_ptr<const Snapshot> old = std::atomic_load(&current);
+        std::vector<Draft> drafts(old->shards.size());
+        hashSet<int> removeSet(removes.begin(), removes.end());
+        size_t removedCount = 0;
+        auto open = [&](size_t index) -> Draft & {
+            Draft &draft = drafts[index];
+            if (!draft.dirty) {
+                const Shard &shard = *old->shards[index];
+                draft.dirty = true;
+                draft.ids = shard.ids;
+                draft.patterns = shard.patterns;
+                draft.dfas = shard.dfas;
+            }
+            return draft;
+        };
+        for (size_t index = 0; index < old->shards.size() && !removeSet.empty(); index++) {
+            const Shard &shard = *old->shards[index];
+            for (size_t i = 0; i < shard.ids.size(); i++) {
+                if (removeSet.find(shard.ids[i]) == removeSet.end())
+                    continue;
+                Draft &draft = open(index);
+                size_t k = std::find(draft.ids.begin(), draft.ids.end(), shard.ids[i]) - draft.ids.begin();
+                draft.ids.erase(draft.ids.begin() + k);
+                draft.patterns.erase(draft.patterns.begin() + k);
+                draft.dfas.erase(draft.dfas.begin() + k);
+                removedCount++;
+            }
+        }
+        //新pattern追加到最后一个分片,分片满后新开一个
+        std::vector<int> newIds;
+        for (size_t i = 0; i < adds.size(); i++) {
+            size_t last = drafts.size() - 1;
+            size_t lastSize = drafts.empty() ? shardSize
+                              : drafts[last].dirty ? drafts[last].ids.size() : old->shards[last]->ids.size();
+            if (lastSize >= shardSize) {
+                drafts.emplace_back();
+                drafts.back().dirty = true;
+                last = drafts.size() - 1;
+            }
+            Draft &draft = last < old->shards.size() ? open(last) : drafts[last];
+            int id = nextId + (int) i;
+            draft.ids.push_back(id);
+            draft.patterns.push_back(adds[i]);
+            draft.dfas.push_back(addDFAs[i]);
+            newIds.push_back(id);
+        }
+
+        //相邻的非空分片中有一个少于shardSize/2且合并后不超过shardSize时合并,保持编号的先后顺序
+        auto sizeOf = [&](size_t index) {
+            return drafts[index].dirty ? drafts[index].ids.size() : old->shards[index]->ids.size();
+        };
+        size_t undersized = shardSize / 2;
+        std::vector<size_t> kept;
+        for (size_t index = 0; index < drafts.size(); index++) {
+            if (sizeOf(index) == 0)
+                continue;
+            if (!kept.empty()) {
+                size_t previous = kept.back();
+                size_t merged = sizeOf(previous) + sizeOf(index);
+                if ((sizeOf(previous) < undersized || sizeOf(index) < undersized) && merged <= shardSize) {
+                    Draft &target = previous < old->shards.size() ? open(previous) : drafts[previous];
+                    Draft &source = index < old->shards.size() ? open(index) : drafts[index];
+                    target.ids.insert(target.ids.end(), source.ids.begin(), source.ids.end());
+                    target.patterns.insert(target.patterns.end(), source.patterns.begin(), source.patterns.end());
+                    target.dfas.insert(target.dfas.end(), source.dfas.begin(), source.dfas.end());
+                    source.ids.clear();
+                    source.patterns.clear();
+                    source.dfas.clear();
+                    continue;
+                }
+            }
+            kept.push_back(index);
+        }
+
+        auto snapshot = std::make_shared<Snapshot>();
+        for (size_t index : kept) {
+            Draft &draft = drafts[index];
+            if (!draft.dirty) {
+                snapshot->shards.push_back(old->shards[index]);
+            } else {
+                snapshot->shards.push_back(buildShard(std::move(draft.ids), std::move(draft.patterns),
+                                                      std::move(draft.dfas)));
+            }
+        }
+        nextId += (int) adds.size();
+        std::atomic_store(&current, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+        if (removed != nullptr)
+            *removed = removedCount;
+        return newIds;
+    }
+
+    //加入一个pattern
+    int RegexSet::add(const std::string &pattern) {
+        return update({pattern}, {})[0];
+    }
+
+    //删除编号为id的pattern
+    bool RegexSet::remove(int id) {
+        size_t removed = 0;
+        update({}, {id}, &removed);
+        return removed > 0;
+    }
+
+    //是否有pattern整体匹配input
+    bool RegexSet::matchAny(std::string_view input) const {
+        std::shared_ptr<const Snapshot> snapshot = std::atomic_load(&current);
+        for (const auto &shard : snapshot->shards) {
+            if (shard->unionDFA->match(input))
+                return true;
+        }
+        return false;
+    }
+
+    //合并DFA匹配时再逐个确认分片内的pattern
+    std::vector<int> RegexSet::matchIds(std::string_view input) const {
+        std::vector<int> ans;
+        std::shared_ptr<const Snapshot> snapshot = std::atomic_load(&current);
+        for (const auto &shard : snapshot->shards) {
+            if (!shard->unionDFA->match(input))
+                continue;
+            for (size_t i = 0; i < shard->dfas.size(); i++) {
+                if (shard->dfas[i]->match(input))
+                    ans.push_back(shard->ids[i]);
+            }
+        }
+        return ans;
+    }
+
+    //pattern个数
+    size_t RegexSet::size() const {
+        std::shared_ptr<const Snapshot> snapshot = std::atomic_load(&current);
+        size_t count = 0;
+        for (const auto &shard : snapshot->shards)
+            count += shard->ids.size();
+        return count;
+    }
+
+    //分片个数
+    size_t RegexSet::shardCount() const {
+        return std::atomic_load(&current)->shards.size();
+    }
+
+    //占用的内存字节数
+    size_t RegexSet::memoryUsage() const {
+        std::shared_ptr<const Snapshot> snapshot = std::atomic_load(&current);
+        size_t bytes = sizeof(RegexSet) + sizeof(Snapshot);
+        for (const auto &shard : snapshot->shards) {
+            bytes += sizeof(Shard) + shard->ids.capacity() * sizeof(int);
+            for (const std::string &pattern : shard->patterns)
+                bytes += sizeof(std::string) + pattern.capacity();
+            if (shard->dfas.size() > 1)
+                bytes += shard->unionDFA->memoryUsage();
+            for (const auto &dfa : shard->dfas)
+                bytes += dfa->memoryUsage();
+        }
+        return bytes;
+    }
+}  // namespace zhRegex
@@ -0,0 +1,79 @@
+#ifndef _ZH_REGEX_SET_H_
+#define _ZH_REGEX_SET_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "DFA.h"
+
+namespace zhRegex {
+    //可增量更新的多pattern匹配器
+    //pattern按加入顺序分片,每个分片有一个合并(p1|p2|...)后的最小DFA用于快速判断,以及各pattern自己的DFA用于确定编号
+    //增删pattern时只重新编译受影响的分片,之后原子地替换快照(RCU):读者只持有旧快照的引用,永远不会被写者阻塞
+    //删除使分片少于shardSize/2个pattern时与相邻分片合并(合并后不超过shardSize),频繁增删后分片数不会无限增长
+    class RegexSet {
+    private:
+        //一个分片,构造完成后不再修改
+        struct Shard {
+            std::vector<int> ids;
+            std::vector<std::string> patterns;
+            //分片内全部pattern的合并DFA
+            std::shared_ptr<DFA> unionDFA;
+            //每个pattern自己的DFA,未改动的pattern在新旧分片之间共享
+            std::vector<std::shared_ptr<DFA>> dfas;
+        };
+
+        //某一时刻的全部分片
+        struct Snapshot {
+            std::vector<std::shared_ptr<const Shard>> shards;
+        };
+
+        //当前快照,只能通过std::atomic_load/std::atomic_store访问
+        std::shared_ptr<const Snapshot> current;
+        //写者之间互斥
+        std::mutex writerMutex;
+        //每个分片最多的pattern个数
+        size_t shardSize;
+        //编译时使用的线程数
+        unsigned threads;
+        //下一个pattern编号
+        int nextId = 0;
+
+        //由ids/patterns/dfas编译一个新的分片
+        std::shared_ptr<const Shard> buildShard(std::vector<int> ids, std::vector<std::string> patterns,
+                                                std::vector<std::shared_ptr<DFA>> dfas) const;
+
+    public:
+        explicit RegexSet(size_t shardSize = 32, unsigned threads = 1);
+
+        RegexSet(const RegexSet &) = delete;
+        RegexSet &operator=(const RegexSet &) = delete;
+
+        //一次加入adds并删除removes中的pattern,每个受影响的分片只编译一次,返回adds的编号
+        // removed不为空时写入实际删除的个数(在写者锁内统计,不受其他写者影响)
+        //任一pattern非法时抛出RegexException,此时集合保持不变
+        std::vector<int> update(const std::vector<std::string> &adds, const std::vector<int> &removes,
+                                size_t *removed = nullptr);
+        //加入一个pattern,返回其编号
+        int add(const std::string &pattern);
+        //删除编号为id的pattern,不存在时返回false
+        bool remove(int id);
+
+        //是否有pattern整体匹配input
+        bool matchAny(std::string_view input) const;
+        //整体匹配input的全部pattern编号(升序)
+        std::vector<int> matchIds(std::string_view input) const;
+
+        //pattern个数
+        size_t size() const;
+        //分片个数
+        size_t shardCount() const;
+        //占用的内存字节数
+        size_t memoryUsage() const;
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_REGEX_SET_H_
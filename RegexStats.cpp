@@ -0,0 +1,419 @@
+#include "RegexStats.h"
+
+#ifdef ZH_REGEX_STATS
+
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace zhRegex {
+    namespace {
+        constexpr int counterCount = (int) StatCounter::count;
+        //每页的pattern个数,每个线程按页懒分配
+        constexpr int pageSize = 64;
+        constexpr int pageCount = RegexStats::maxPatterns / pageSize;
+
+        //一个pattern在一个线程中的计数
+        struct StatsBlock {
+            std::atomic<uint64_t> counters[counterCount]{};
+            std::atomic<uint64_t> latency[RegexStats::latencyBuckets]{};
+        };
+
+        struct StatsPage {
+            StatsBlock blocks[pageSize];
+        };
+
+        //编译时记录的信息
+        struct PatternInfo {
+            std::string pattern;
+            const char *engine;
+            uint64_t compileNanos;
+            int states;
+            size_t bytes;
+            //编号已释放时为false
+            bool live = true;
+        };
+
+        //汇总后的计数
+        struct StatsTotal {
+            uint64_t counters[counterCount]{};
+            uint64_t latency[RegexStats::latencyBuckets]{};
+        };
+
+        struct ThreadStats;
+
+        //全局注册表,只有注册pattern、线程进出与快照时加锁
+        struct StatsRegistry {
+            std::mutex mutex;
+            std::vector<PatternInfo> patterns;
+            std::unordered_set<ThreadStats *> threads;
+            //已退出线程的计数
+            std::vector<StatsTotal> retired;
+            //编号释放时的累计计数,复用该编号的pattern只统计此后的增量
+            std::vector<StatsTotal> baseline;
+            //已释放、可复用的编号
+            std::vector<int> freeIds;
+            //因超出maxPatterns而未统计的注册次数
+            uint64_t dropped = 0;
+
+            static StatsRegistry &instance() {
+                //不析构,避免线程在程序退出时访问已销毁的注册表
+                static StatsRegistry *registry = new StatsRegistry();
+                return *registry;
+            }
+        };
+
+        //一个线程的全部计数,页指针只由所属线程写入
+        struct ThreadStats {
+            std::atomic<StatsPage *> pages[pageCount]{};
+
+            ThreadStats() {
+                StatsRegistry &registry = StatsRegistry::instance();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                registry.threads.insert(this);
+            }
+
+            //线程退出时将计数并入retired
+            ~ThreadStats() {
+                StatsRegistry &registry = StatsRegistry::instance();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                registry.threads.erase(this);
+                for (int page = 0; page < pageCount; page++) {
+                    StatsPage *stats = pages[page].load(std::memory_order_relaxed);
+                    if (stats == nullptr)
+                        continue;
+                    for (int k = 0; k < pageSize; k++) {
+                        size_t id = (size_t) page * pageSize + k;
+                        if (id >= registry.retired.size())
+                            break;
+                        StatsTotal &total = registry.retired[id];
+                        for (int c = 0; c < counterCount; c++)
+                            total.counters[c] += stats->blocks[k].counters[c].load(std::memory_order_relaxed);
+                        for (int b = 0; b < RegexStats::latencyBuckets; b++)
+                            total.latency[b] += stats->blocks[k].latency[b].load(std::memory_order_relaxed);
+                    }
+                    delete stats;
+                }
+            }
+
+            inline StatsBlock &block(int id) {
+                std::atomic<StatsPage *> &page = pages[id / pageSize];
+                StatsPage *stats = page.load(std::memory_order_relaxed);
+                if (stats == nullptr) {
+                    stats = new StatsPage();
+                    //快照线程可能同时读取
+                    page.store(stats, std::memory_order_release);
+                }
+                return stats->blocks[id % pageSize];
+            }
+        };
+
+        inline ThreadStats &localStats() {
+            thread_local ThreadStats stats;
+            return stats;
+        }
+
+        //只有所属线程写入,无需read-modify-write
+        inline void bump(std::atomic<uint64_t> &counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        //编号id在全部线程中的累计计数(不扣除baseline),调用者须持有registry.mutex
+        StatsTotal collectOne(StatsRegistry &registry, int id) {
+            StatsTotal total = registry.retired[id];
+            for (ThreadStats *thread : registry.threads) {
+                StatsPage *stats = thread->pages[id / pageSize].load(std::memory_order_acquire);
+                if (stats == nullptr)
+                    continue;
+                const StatsBlock &block = stats->blocks[id % pageSize];
+                for (int c = 0; c < counterCount; c++)
+                    total.counters[c] += block.counters[c].load(std::memory_order_relaxed);
+                for (int b = 0; b < RegexStats::latencyBuckets; b++)
+                    total.latency[b] += block.latency[b].load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        //汇总全部线程的计数并扣除baseline,调用者须持有registry.mutex
+        std::vector<StatsTotal> collect(StatsRegistry &registry) {
+            std::vector<StatsTotal> totals = registry.retired;
+            for (ThreadStats *thread : registry.threads) {
+                for (int page = 0; page < pageCount; page++) {
+                    StatsPage *stats = thread->pages[page].load(std::memory_order_acquire);
+                    if (stats == nullptr)
+                        continue;
+                    for (int k = 0; k < pageSize; k++) {
+                        size_t id = (size_t) page * pageSize + k;
+                        if (id >= totals.size())
+                            break;
+                        for (int c = 0; c < counterCount; c++)
+                            totals[id].counters[c] += stats->blocks[k].counters[c].load(std::memory_order_relaxed);
+                        for (int b = 0; b < RegexStats::latencyBuckets; b++)
+                            totals[id].latency[b] += stats->blocks[k].latency[b].load(std::memory_order_relaxed);
+                    }
+                }
+            }
+            for (size_t id = 0; id < totals.size(); id++) {
+                for (int c = 0; c < counterCount; c++)
+                    totals[id].counters[c] -= registry.baseline[id].counters[c];
+                for (int b = 0; b < RegexStats::latencyBuckets; b++)
+                    totals[id].latency[b] -= registry.baseline[id].latency[b];
+            }
+            return totals;
+        }
+
+        //JSON字符串转义
+        void appendJSONString(std::string &out, std::string_view s) {
+            static const char hex[] = "0123456789abcdef";
+            out += '"';
+            for (char c : s) {
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += c;
+                } else if ((unsigned char) c < 0x20) {
+                    out += "\\u00";
+                    out += hex[(unsigned char) c >> 4];
+                    out += hex[c & 15];
+                } else {
+                    out += c;
+                }
+            }
+            out += '"';
+        }
+
+        // Prometheus标签值转义
+        void appendLabel(std::string &out, std::string_view s) {
+            out += '"';
+            for (char c : s) {
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += c;
+                } else if (c == '\n') {
+                    out += "\\n";
+                } else {
+                    out += c;
+                }
+            }
+            out += '"';
+        }
+
+        const char *const counterNames[counterCount] = {
+                "match_calls", "prefix_calls", "contains_calls", "anywhere_calls", "count_calls", "batch_inputs",
+                "bytes_scanned", "bytes_skipped", "prefilter_rejects", "matches_found", "latency_nanos"};
+    }  // namespace
+
+    //注册一个pattern
+    int RegexStats::registerCompiled(std::string_view pattern, const char *engine, Clock::time_point begin,
+                                     int states, size_t bytes) {
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin);
+        StatsRegistry &registry = StatsRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        PatternInfo info{std::string(pattern), engine, (uint64_t) nanos.count(), states, bytes};
+        if (!registry.freeIds.empty()) {
+            int id = registry.freeIds.back();
+            registry.freeIds.pop_back();
+            registry.patterns[id] = std::move(info);
+            return id;
+        }
+        if (registry.patterns.size() >= (size_t) maxPatterns) {
+            registry.dropped++;
+            return -1;
+        }
+        registry.patterns.push_back(std::move(info));
+        registry.retired.emplace_back();
+        registry.baseline.emplace_back();
+        return (int) registry.patterns.size() - 1;
+    }
+
+    //释放编号,记下当前的累计计数作为下一个使用者的起点
+    void RegexStats::unregisterCompiled(int id) {
+        if (id < 0)
+            return;
+        StatsRegistry &registry = StatsRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if ((size_t) id >= registry.patterns.size() || !registry.patterns[id].live)
+            return;
+        registry.baseline[id] = collectOne(registry, id);
+        registry.patterns[id].live = false;
+        registry.patterns[id].pattern = std::string();
+        registry.freeIds.push_back(id);
+    }
+
+    //因超出maxPatterns而未统计的注册次数
+    uint64_t RegexStats::droppedRegistrations() {
+        StatsRegistry &registry = StatsRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        return registry.dropped;
+    }
+
+    //编号为id的pattern
+    std::string RegexStats::patternOf(int id) {
+        StatsRegistry &registry = StatsRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (id < 0 || (size_t) id >= registry.patterns.size() || !registry.patterns[id].live)
+            return std::string();
+        return registry.patterns[id].pattern;
+    }
+
+    //累加当前线程的计数
+    void RegexStats::add(int id, StatCounter counter, uint64_t value) {
+        if (id < 0 || value == 0)
+            return;
+        bump(localStats().block(id).counters[(int) counter], value);
+    }
+
+    //记录当前线程的一次调用耗时
+    void RegexStats::addLatency(int id, uint64_t nanos) {
+        if (id < 0)
+            return;
+        StatsBlock &block = localStats().block(id);
+        bump(block.counters[(int) StatCounter::latencyNanos], nanos);
+        int bucket = 0;
+        while (bucket + 1 < latencyBuckets && (nanos >> (bucket + 1)) != 0)
+            bucket++;
+        bump(block.latency[bucket], 1);
+    }
+
+    //JSON快照
+    //{"patterns":[{"id":0,"pattern":"...","engine":"dfa","compile_nanos":..,"states":..,"table_bytes":..,
+    //  "match_calls":..,...,"skip_ratio":..,"latency_buckets":[..]}]},latency_buckets[b]为[2^b, 2^(b + 1))纳秒内的次数
+    std::string RegexStats::toJSON() {
+        StatsRegistry &registry = StatsRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        std::vector<StatsTotal> totals = collect(registry);
+        std::string out = "{\"dropped_registrations\":" + std::to_string(registry.dropped) + ",\"patterns\":[";
+        bool first = true;
+        for (size_t id = 0; id < registry.patterns.size(); id++) {
+            const PatternInfo &info = registry.patterns[id];
+            const StatsTotal &total = totals[id];
+            if (!info.live)
+                continue;
+            if (!first)
+                out += ',';
+            first = false;
+            out += "{\"id\":" + std::to_string(id) + ",\"pattern\":";
+            appendJSONString(out, info.pattern);
+            out += ",\"engine\":";
+            appendJSONString(out, info.engine);
+            out += ",\"compile_nanos\":" + std::to_string(info.compileNanos);
+            out += ",\"states\":" + std::to_string(info.states);
+            out += ",\"table_bytes\":" + std::to_string(info.bytes);
+            for (int c = 0; c < counterCount; c++) {
+                out += ",\"";
+                out += counterNames[c];
+                out += "\":" + std::to_string(total.counters[c]);
+            }
+            uint64_t scanned = total.counters[(int) StatCounter::bytesScanned];
+            uint64_t skipped = total.counters[(int) StatCounter::bytesSkipped];
+            out += ",\"skip_ratio\":" + std::to_string(scanned == 0 ? 0.0 : (double) skipped / (double) scanned);
+            out += ",\"latency_buckets\":[";
+            for (int b = 0; b < latencyBuckets; b++) {
+                if (b > 0)
+                    out += ',';
+                out += std::to_string(total.latency[b]);
+            }
+            out += "]}";
+        }
+        out += "]}";
+        return out;
+    }
+
+    // Prometheus文本格式快照,每个pattern以pattern与engine两个标签区分,已释放的编号标签为空、不输出
+    std::string RegexStats::toPrometheus() {
+        StatsRegistry &registry = StatsRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        std::vector<StatsTotal> totals = collect(registry);
+        std::vector<std::string> labels;
+        for (const PatternInfo &info : registry.patterns) {
+            if (!info.live) {
+                labels.emplace_back();
+                continue;
+            }
+            std::string label = "pattern=";
+            appendLabel(label, info.pattern);
+            label += ",engine=";
+            appendLabel(label, info.engine);
+            labels.emplace_back(std::move(label));
+        }
+        std::string out = "# HELP zhregex_dropped_registrations_total Patterns not tracked because the registry was full.\n"
+                          "# TYPE zhregex_dropped_registrations_total counter\n"
+                          "zhregex_dropped_registrations_total " + std::to_string(registry.dropped) + '\n';
+        auto gauge = [&](const char *name, const char *help, auto &&value) {
+            out += std::string("# HELP zhregex_") + name + ' ' + help + "\n# TYPE zhregex_" + name + " gauge\n";
+            for (size_t id = 0; id < labels.size(); id++) {
+                if (!labels[id].empty())
+                    out += std::string("zhregex_") + name + '{' + labels[id] + "} " + value(id) + '\n';
+            }
+        };
+        gauge("compile_seconds", "Time spent compiling the pattern.", [&](size_t id) {
+            return std::to_string((double) registry.patterns[id].compileNanos / 1e9);
+        });
+        gauge("states", "Number of automaton states.", [&](size_t id) {
+            return std::to_string(registry.patterns[id].states);
+        });
+        gauge("table_bytes", "Memory used by the compiled pattern.", [&](size_t id) {
+            return std::to_string(registry.patterns[id].bytes);
+        });
+        for (int c = 0; c < (int) StatCounter::latencyNanos; c++) {
+            out += std::string("# TYPE zhregex_") + counterNames[c] + "_total counter\n";
+            for (size_t id = 0; id < labels.size(); id++) {
+                if (labels[id].empty())
+                    continue;
+                out += std::string("zhregex_") + counterNames[c] + "_total{" + labels[id] + "} " +
+                       std::to_string(totals[id].counters[c]) + '\n';
+            }
+        }
+        out += "# HELP zhregex_call_latency_seconds Latency of single match/matchPrefix/contains calls.\n"
+               "# TYPE zhregex_call_latency_seconds histogram\n";
+        for (size_t id = 0; id < labels.size(); id++) {
+            if (labels[id].empty())
+                continue;
+            uint64_t cumulative = 0;
+            for (int b = 0; b < latencyBuckets; b++) {
+                cumulative += totals[id].latency[b];
+                out += "zhregex_call_latency_seconds_bucket{" + labels[id] + ",le=\"" +
+                       std::to_string((double) (1ULL << (b + 1)) / 1e9) + "\"} " + std::to_string(cumulative) + '\n';
+            }
+            out += "zhregex_call_latency_seconds_bucket{" + labels[id] + ",le=\"+Inf\"} " +
+                   std::to_string(cumulative) + '\n';
+            out += "zhregex_call_latency_seconds_sum{" + labels[id] + "} " +
+                   std::to_string((double) totals[id].counters[(int) StatCounter::latencyNanos] / 1e9) + '\n';
+            out += "zhregex_call_latency_seconds_count{" + labels[id] + "} " + std::to_string(cumulative) + '\n';
+        }
+        return out;
+    }
+}  // namespace zhRegex
+
+#else
+
+namespace zhRegex {
+    //未启用统计时只保留空实现,调用处的宏均已展开为空
+    int RegexStats::registerCompiled(std::string_view, const char *, Clock::time_point, int, size_t) {
+        return -1;
+    }
+
+    void RegexStats::unregisterCompiled(int) {}
+
+    uint64_t RegexStats::droppedRegistrations() {
+        return 0;
+    }
+
+    std::string RegexStats::patternOf(int) {
+        return std::string();
+    }
+
+    void RegexStats::add(int, StatCounter, uint64_t) {}
+
+    void RegexStats::addLatency(int, uint64_t) {}
+
+    std::string RegexStats::toJSON() {
+        return "{\"dropped_registrations\":0,\"patterns\":[]}";
+    }
+
+    std::string RegexStats::toPrometheus() {
+        return std::string();
+    }
+}  // namespace zhRegex
+
+#endif  // ZH_REGEX_STATS
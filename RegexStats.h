@@ -0,0 +1,131 @@
+#ifndef _ZH_REGEX_STATS_H_
+#define _ZH_REGEX_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+运行统计,定义ZH_REGEX_STATS(cmake -DZH_REGEX_STATS=ON)时才会编译进来
+未定义时下面的ZH_STATS_*宏全部展开为空,Pattern中也没有statsId,热路径没有任何额外开销
+计数器按线程存放,只有所属线程写入(relaxed原子变量,无锁),快照时汇总全部线程
+*/
+
+namespace zhRegex {
+    //各项计数
+    enum class StatCounter : int {
+        matchCalls,        // match调用次数
+        prefixCalls,       // matchPrefix调用次数
+        containsCalls,     // contains调用次数
+        anywhereCalls,     // isMatchAnywhere调用次数
+        countCalls,        // count调用次数
+        batchInputs,       // matchBatch/containsBatch处理的输入个数
+        bytesScanned,      //输入的总字节数
+        bytesSkipped,      //加速态直接跳过的字节数
+        prefilterRejects,  //预过滤直接判定不匹配的次数
+        matchesFound,      //匹配成功的次数(contains为找到的子串个数)
+        latencyNanos,      //单次调用的总耗时
+        count
+    };
+
+    class RegexStats {
+    public:
+        //延迟直方图的桶数,第b个桶为[2^b, 2^(b + 1))纳秒
+        static constexpr int latencyBuckets = 40;
+        //最多同时统计的pattern个数,超出后新的pattern不再统计(计入droppedRegistrations)
+        //pattern析构时释放编号,供之后编译的pattern复用
+        static constexpr int maxPatterns = 1 << 16;
+        using Clock = std::chrono::steady_clock;
+
+        //是否编译了统计
+        static constexpr bool enabled() {
+#ifdef ZH_REGEX_STATS
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        //注册一个pattern并记录其编译耗时、状态数与占用字节数,返回编号,超出maxPatterns时返回-1
+        static int registerCompiled(std::string_view pattern, const char *engine, Clock::time_point begin,
+                                    int states, size_t bytes);
+        //释放编号,由Pattern析构时调用,之后快照中不再出现该pattern
+        static void unregisterCompiled(int id);
+        //因超出maxPatterns而未统计的注册次数
+        static uint64_t droppedRegistrations();
+        //编号为id的pattern,不存在时返回空串
+        static std::string patternOf(int id);
+
+        //累加当前线程的计数
+        static void add(int id, StatCounter counter, uint64_t value);
+        //记录当前线程的一次调用耗时
+        static void addLatency(int id, uint64_t nanos);
+
+        //全部pattern的快照,JSON格式
+        static std::string toJSON();
+        //全部pattern的快照,Prometheus文本格式
+        static std::string toPrometheus();
+    };
+
+    //统计一次调用(或一批输入):析构时记录次数、字节数、匹配数,单次调用还记录耗时
+    class StatsCall {
+    private:
+        int id;
+        StatCounter kind;
+        uint64_t calls;
+        uint64_t bytes;
+        uint64_t matches = 0;
+        RegexStats::Clock::time_point begin;
+
+    public:
+        StatsCall(int id, StatCounter kind, uint64_t calls, uint64_t bytes)
+                : id(id), kind(kind), calls(calls), bytes(bytes), begin(RegexStats::Clock::now()) {}
+
+        StatsCall(const StatsCall &) = delete;
+        StatsCall &operator=(const StatsCall &) = delete;
+
+        inline void found(uint64_t count) {
+            matches += count;
+        }
+
+        ~StatsCall() {
+            if (id < 0)
+                return;
+            RegexStats::add(id, kind, calls);
+            RegexStats::add(id, StatCounter::bytesScanned, bytes);
+            RegexStats::add(id, StatCounter::matchesFound, matches);
+            //一批输入的总耗时不计入单次调用的延迟
+            if (kind != StatCounter::batchInputs) {
+                auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(RegexStats::Clock::now() - begin);
+                RegexStats::addLatency(id, (uint64_t) nanos.count());
+            }
+        }
+    };
+}  // namespace zhRegex
+
+#ifdef ZH_REGEX_STATS
+//记录编译开始的时间
+#define ZH_STATS_COMPILE_BEGIN() auto zhStatsCompileBegin = ::zhRegex::RegexStats::Clock::now()
+//注册当前pattern,states为状态数
+#define ZH_STATS_COMPILE_END(pattern, engine, states) \
+    (statsId = ::zhRegex::RegexStats::registerCompiled((pattern), (engine), zhStatsCompileBegin, (states), memoryUsage()))
+//统计当前作用域内的calls次调用
+#define ZH_STATS_CALL(id, kind, calls, bytes) ::zhRegex::StatsCall zhStatsCall((id), (kind), (calls), (bytes))
+//当前调用找到的匹配数
+#define ZH_STATS_FOUND(count) zhStatsCall.found(count)
+//累加计数
+#define ZH_STATS_ADD(id, counter, value) ::zhRegex::RegexStats::add((id), (counter), (value))
+//只在启用统计时保留的语句
+#define ZH_STATS_ONLY(...) __VA_ARGS__
+#else
+#define ZH_STATS_COMPILE_BEGIN() ((void) 0)
+#define ZH_STATS_COMPILE_END(pattern, engine, states) ((void) 0)
+#define ZH_STATS_CALL(id, kind, calls, bytes) ((void) 0)
+#define ZH_STATS_FOUND(count) ((void) 0)
+#define ZH_STATS_ADD(id, counter, value) ((void) 0)
+#define ZH_STATS_ONLY(...)
+#endif
+
+#endif  // !_ZH_REGEX_STATS_H_
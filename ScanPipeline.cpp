@@ -0,0 +1,245 @@
+#include "ScanPipeline.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace zhRegex {
+    namespace {
+        //有界阻塞队列,容量由放入的元素个数(缓冲区个数)决定
+        template <typename T>
+        class BlockingQueue {
+        private:
+            std::mutex mutex;
+            std::condition_variable ready;
+            std::deque<T> items;
+            bool closed = false;
+
+        public:
+            void push(T item) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    items.push_back(std::move(item));
+                }
+                ready.notify_one();
+            }
+
+            //队列为空且已关闭时返回false
+            bool pop(T &item) {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this]() { return !items.empty() || closed; });
+                if (items.empty())
+                    return false;
+                item = std::move(items.front());
+                items.pop_front();
+                return true;
+            }
+
+            void close() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    closed = true;
+                }
+                ready.notify_all();
+            }
+        };
+
+        //一块输入及其匹配结果
+        struct Block {
+            std::vector<char> data;
+            //有效长度,以\n结尾(文件最后一块除外)
+            size_t length = 0;
+            size_t file = 0;
+            //在文件中的偏移
+            size_t offset = 0;
+            //是否为文件的最后一块
+            bool last = false;
+            bool error = false;
+            //匹配的行(行号相对于本块)与本块的行数
+            std::vector<LineMatch> lines;
+            size_t newlines = 0;
+        };
+
+        //读满buffer[0, size),返回读到的字节数,出错时返回-1
+        long readFully(int fd, char *buffer, size_t size) {
+            size_t total = 0;
+            while (total < size) {
+                ssize_t n = ::read(fd, buffer + total, size - total);
+                if (n < 0)
+                    return -1;
+                if (n == 0)
+                    break;
+                total += (size_t) n;
+            }
+            return (long) total;
+        }
+    }  // namespace
+
+    ScanPipeline::ScanPipeline(const LineSearcher &searcher, const ScanOptions &options)
+            : searcher(searcher), options(options) {
+        this->options.blockSize = std::max<size_t>(this->options.blockSize, 1);
+        this->options.buffers = std::max<size_t>(this->options.buffers, 2);
+        this->options.readers = std::max(this->options.readers, 1u);
+        this->options.matchers = std::max(this->options.matchers, 1u);
+    }
+
+    //扫描files
+    size_t ScanPipeline::scan(const std::vector<std::string> &files, const ScanCallbacks &callbacks) {
+        //每个读取线程至少拥有两块缓冲区,文件数少于线程数时多余的线程无事可做
+        unsigned readers = (unsigned) std::min<size_t>({options.readers, options.buffers / 2,
+                                                        std::max<size_t>(files.size(), 1)});
+        std::vector<Block> blocks(options.buffers);
+        //缓冲区i归读取线程i % readers所有,输出后归还给所有者
+        std::vector<BlockingQueue<size_t>> freeBlocks(readers);
+        BlockingQueue<size_t> readBlocks;
+        for (size_t i = 0; i < blocks.size(); i++)
+            freeBlocks[i % readers].push(i);
+        //匹配完成的块按文件及块在文件中的序号存放,由调用线程按文件顺序、序号顺序取出
+        std::mutex doneMutex;
+        std::condition_variable doneReady;
+        std::vector<std::vector<long>> doneBySequence(files.size());
+        std::vector<size_t> sequenceOf(blocks.size());
+        //下一个待读取的文件,读取线程按文件顺序领取
+        std::atomic<size_t> nextFile{0};
+
+        //调用线程输出到文件f时,f之前的文件都已输出完毕,它们占用的缓冲区已归还,
+        //因此读取文件f的线程总能拿到自己的缓冲区,各线程领先读取后续文件也不会死锁
+        auto read = [&](unsigned reader) {
+            size_t index = 0;
+            for (size_t file = nextFile++; file < files.size(); file = nextFile++) {
+                int fd = ::open(files[file].c_str(), O_RDONLY);
+                //上一块末尾不完整的行
+                std::vector<char> carry;
+                size_t offset = 0;
+                size_t sequence = 0;
+                bool eof = fd < 0;
+                bool error = fd < 0;
+                do {
+                    freeBlocks[reader].pop(index);
+                    Block &block = blocks[index];
+                    block.file = file;
+                    block.offset = offset;
+                    block.error = false;
+                    block.data.resize(std::max(block.data.size(), carry.size() + options.blockSize));
+                    std::copy(carry.begin(), carry.end(), block.data.begin());
+                    size_t total = carry.size();
+                    carry.clear();
+                    const char *cut = nullptr;
+                    //一行比整块还长时继续在同一块中读取
+                    while (!eof) {
+                        if (block.data.size() - total < options.blockSize)
+                            block.data.resize(total + options.blockSize);
+                        long n = readFully(fd, block.data.data() + total, options.blockSize);
+                        if (n < 0) {
+                            eof = error = true;
+                            break;
+                        }
+                        size_t before = total;
+                        total += (size_t) n;
+                        if ((size_t) n < options.blockSize)
+                            eof = true;
+                        for (const char *p = block.data.data() + total; p > block.data.data() + before;) {
+                            --p;
+                            if (*p == '\n') {
+                                cut = p + 1;
+                                break;
+                            }
+                        }
+                        if (cut != nullptr)
+                            break;
+                    }
+                    if (!eof && cut != nullptr) {
+                        carry.assign(cut, (const char *) block.data.data() + total);
+                        total = cut - block.data.data();
+                    }
+                    block.length = error ? 0 : total;
+                    block.error = error;
+                    block.last = eof;
+                    offset += block.length;
+                    sequenceOf[index] = sequence++;
+                    readBlocks.push(index);
+                } while (!eof);
+                if (fd >= 0)
+                    ::close(fd);
+            }
+        };
+        std::vector<std::thread> readerThreads;
+        for (unsigned reader = 0; reader < readers; reader++)
+            readerThreads.emplace_back(read, reader);
+
+        std::vector<std::thread> matchers;
+        for (unsigned worker = 0; worker < options.matchers; worker++) {
+            matchers.emplace_back([&]() {
+                size_t index;
+                while (readBlocks.pop(index)) {
+                    Block &block = blocks[index];
+                    block.lines.clear();
+                    block.newlines = 0;
+                    if (!block.error) {
+                        std::string_view input(block.data.data(), block.length);
+                        searcher.forEachLine(input, options.invert, [&block](const LineMatch &line) {
+                            block.lines.push_back(line);
+                        });
+                        block.newlines = (size_t) std::count(input.begin(), input.end(), '\n');
+                    }
+                    std::lock_guard<std::mutex> lock(doneMutex);
+                    std::vector<long> &done = doneBySequence[block.file];
+                    size_t sequence = sequenceOf[index];
+                    if (done.size() <= sequence)
+                        done.resize(sequence + 1, -1);
+                    done[sequence] = (long) index;
+                    doneReady.notify_all();
+                }
+            });
+        }
+
+        //按文件顺序、序号顺序输出,每个文件至少有一块且最后一块的last为true
+        size_t matchedTotal = 0;
+        for (size_t file = 0; file < files.size(); file++) {
+            size_t lineBase = 0, matched = 0;
+            for (size_t next = 0;; next++) {
+                size_t index = 0;
+                {
+                    std::unique_lock<std::mutex> lock(doneMutex);
+                    const std::vector<long> &done = doneBySequence[file];
+                    doneReady.wait(lock, [&]() { return next < done.size() && done[next] >= 0; });
+                    index = (size_t) done[next];
+                }
+                Block &block = blocks[index];
+                bool last = block.last;
+                if (block.error) {
+                    if (callbacks.onError)
+                        callbacks.onError(block.file);
+                } else {
+                    for (const LineMatch &line : block.lines) {
+                        if (callbacks.onLine)
+                            callbacks.onLine(ScanLine{block.file, lineBase + line.lineNumber,
+                                                      block.offset + line.offset, line.text});
+                    }
+                    lineBase += block.newlines;
+                    matched += block.lines.size();
+                    if (last && callbacks.onFileEnd)
+                        callbacks.onFileEnd(block.file, matched);
+                }
+                freeBlocks[index % readers].push(index);
+                if (last)
+                    break;
+            }
+            matchedTotal += matched;
+            std::lock_guard<std::mutex> lock(doneMutex);
+            doneBySequence[file] = std::vector<long>();
+        }
+        for (std::thread &reader : readerThreads)
+            reader.join();
+        readBlocks.close();
+        for (std::thread &matcher : matchers)
+            matcher.join();
+        return matchedTotal;
+    }
+}  // namespace zhRegex
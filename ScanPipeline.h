@@ -0,0 +1,63 @@
+#ifndef _ZH_SCAN_PIPELINE_H_
+#define _ZH_SCAN_PIPELINE_H_
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LineSearcher.h"
+
+namespace zhRegex {
+    //流水线扫描的参数
+    struct ScanOptions {
+        //每次读取的字节数,超过该长度的行会使缓冲区按需增长
+        size_t blockSize = 1 << 20;
+        //可复用的缓冲区个数,读取最多领先匹配与输出这么多块,内存上限约为buffers * blockSize
+        size_t buffers = 8;
+        //读取线程数,各线程按文件顺序领取整个文件,文件多且单个文件读取较慢(如网络文件系统)时可重叠读取的等待
+        unsigned readers = 1;
+        //匹配线程数
+        unsigned matchers = 1;
+        //输出不匹配的行
+        bool invert = false;
+    };
+
+    //一个匹配的行,text只在回调期间有效
+    struct ScanLine {
+        //文件在files中的下标
+        size_t file;
+        //行号,从1开始
+        size_t lineNumber;
+        //行首在文件中的偏移
+        size_t offset;
+        std::string_view text;
+    };
+
+    //扫描结果的回调,均在调用scan的线程中按文件顺序、行顺序依次调用
+    struct ScanCallbacks {
+        std::function<void(const ScanLine &)> onLine;
+        //文件扫描完成,matched为匹配的行数
+        std::function<void(size_t file, size_t matched)> onFileEnd;
+        //文件无法打开或读取
+        std::function<void(size_t file)> onError;
+    };
+
+    //多文件流水线扫描:读取、匹配与输出同时进行
+    //读取线程各自领取文件并按块读入缓冲池,每块在最后一个\n处截断,剩余部分并入下一块,因此每块都是完整的行,
+    //匹配线程各自处理一块,调用线程按文件顺序、块顺序输出结果后归还缓冲区;
+    //缓冲池平分给各读取线程,某个读取线程的缓冲区用完时它阻塞(反压)
+    class ScanPipeline {
+    private:
+        const LineSearcher &searcher;
+        ScanOptions options;
+
+    public:
+        ScanPipeline(const LineSearcher &searcher, const ScanOptions &options = ScanOptions());
+
+        //扫描files,返回匹配的总行数
+        size_t scan(const std::vector<std::string> &files, const ScanCallbacks &callbacks);
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_SCAN_PIPELINE_H_
@@ -0,0 +1,124 @@
+#include "SubsetBuilder.h"
+
+#include <cstring>
+
+namespace zhRegex {
+    // class ByteClasses
+    ByteClasses::ByteClasses(const std::vector<const NFANode *> &edges) {
+        int classCount = 1;
+        //单字符边只需细分一次,字符集边按指针去重
+        bool seenChar[256]{};
+        hashSet<const CharSet *> seenSets;
+        std::vector<int> split;
+        for (const NFANode *edge : edges) {
+            if (edge->edgeType == NFAEdgeType::normalChar) {
+                if (seenChar[(unsigned char) edge->edgeValue])
+                    continue;
+                seenChar[(unsigned char) edge->edgeValue] = true;
+            } else if (edge->edgeType != NFAEdgeType::charCollection || edge->edgeValue == '.'
+                       || !seenSets.emplace(edge->edgeSet.get()).second) {
+                //.接受全部字节,不会细分
+                continue;
+            }
+            //(旧类,是否被接受) -> 新类,按字节顺序编号以保证结果确定
+            split.assign(classCount * 2, -1);
+            int next = 0;
+            for (int b = 0; b < 256; b++) {
+                int key = classMap[b] * 2 + (edge->acceptChar((char) b) ? 1 : 0);
+                if (split[key] < 0)
+                    split[key] = next++;
+                classMap[b] = (uint16_t) split[key];
+            }
+            classCount = next;
+            if (classCount == 256)
+                break;
+        }
+        members.resize(classCount);
+        for (int b = 0; b < 256; b++) {
+            members[classMap[b]].push_back((char) b);
+        }
+    }
+
+    ByteClasses::ByteClasses() : members(1) {
+        for (int b = 0; b < 256; b++) {
+            members[0].push_back((char) b);
+        }
+    }
+
+    //(旧类,key) -> 新类,按字节顺序编号以保证结果确定
+    void ByteClasses::refine(const std::vector<uint32_t> &keys) {
+        hashMap<uint64_t, int> split;
+        for (int b = 0; b < 256; b++) {
+            uint64_t key = (uint64_t) classMap[b] << 32 | keys[b];
+            classMap[b] = (uint16_t) split.emplace(key, (int) split.size()).first->second;
+        }
+        members.assign(split.size(), std::vector<char>());
+        for (int b = 0; b < 256; b++) {
+            members[classMap[b]].push_back((char) b);
+        }
+    }
+
+    //同一类中的字节对任意边的结果相同,只需检查每类的第一个字节
+    void ByteClasses::acceptedClasses(const NFANode &edge, std::vector<uint16_t> &classes) const {
+        classes.clear();
+        for (int cls = 0; cls < count(); cls++) {
+            if (edge.acceptChar(members[cls][0]))
+                classes.push_back((uint16_t) cls);
+        }
+    }
+
+    // class StateSetArena
+    //逐个元素混合后再做一次终混合(splitmix64),不同集合几乎不会冲突
+    uint64_t StateSetArena::hashOf(const uint32_t *states, size_t count) {
+        uint64_t hash = 0x243f6a8885a308d3ULL ^ count;
+        for (size_t i = 0; i < count; i++) {
+            hash = (hash ^ states[i]) * 0x9e3779b97f4a7c15ULL;
+            hash ^= hash >> 29;
+        }
+        hash ^= hash >> 30;
+        hash *= 0xbf58476d1ce4e5b9ULL;
+        hash ^= hash >> 27;
+        hash *= 0x94d049bb133111ebULL;
+        hash ^= hash >> 31;
+        return hash;
+    }
+
+    void StateSetArena::grow() {
+        size_t capacity = slots.empty() ? 64 : slots.size() * 2;
+        slots.assign(capacity, -1);
+        size_t mask = capacity - 1;
+        for (int id = 0; id < size(); id++) {
+            size_t slot = hashes[id] & mask;
+            while (slots[slot] >= 0)
+                slot = (slot + 1) & mask;
+            slots[slot] = id;
+        }
+    }
+
+    int StateSetArena::intern(const std::vector<uint32_t> &states, bool &inserted) {
+        //装载因子不超过1/2
+        if ((size_t) size() * 2 >= slots.size())
+            grow();
+        uint64_t hash = hashOf(states.data(), states.size());
+        size_t mask = slots.size() - 1;
+        size_t slot = hash & mask;
+        while (slots[slot] >= 0) {
+            int id = slots[slot];
+            uint32_t begin = offsets[id];
+            uint32_t length = offsets[id + 1] - begin;
+            if (hashes[id] == hash && length == states.size()
+                && std::memcmp(data.data() + begin, states.data(), length * sizeof(uint32_t)) == 0) {
+                inserted = false;
+                return id;
+            }
+            slot = (slot + 1) & mask;
+        }
+        int id = size();
+        slots[slot] = id;
+        hashes.push_back(hash);
+        data.insert(data.end(), states.begin(), states.end());
+        offsets.push_back((uint32_t) data.size());
+        inserted = true;
+        return id;
+    }
+}  // namespace zhRegex
@@ -0,0 +1,182 @@
+#ifndef _ZH_SUBSET_BUILDER_H_
+#define _ZH_SUBSET_BUILDER_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "CompileLimits.h"
+#include "Look.h"
+#include "NFA.h"
+#include "Parallel.h"
+
+namespace zhRegex {
+    //字节等价类:被所有边同等对待的字节归为一类
+    //同一类中的字节转移到的状态集合必然相同,子集构造时每类只需计算一次
+    class ByteClasses {
+    private:
+        //字节(按unsigned char) -> 类编号
+        uint16_t classMap[256]{};
+        //每个类包含的字节
+        std::vector<std::vector<char>> members;
+
+    public:
+        //全部字节为同一类
+        ByteClasses();
+        //用edges中每条边可接受的字符集细分全部字节
+        explicit ByteClasses(const std::vector<const NFANode *> &edges);
+
+        //按keys(每个字节一个)继续细分:同类且key相同的字节仍为一类
+        void refine(const std::vector<uint32_t> &keys);
+
+        //类的个数
+        inline int count() const {
+            return (int) members.size();
+        }
+
+        inline int classOf(char c) const {
+            return classMap[(unsigned char) c];
+        }
+
+        //类cls包含的字节
+        inline const std::vector<char> &bytesOf(int cls) const {
+            return members[cls];
+        }
+
+        //边可以接受的全部类(升序)
+        void acceptedClasses(const NFANode &edge, std::vector<uint16_t> &classes) const;
+    };
+
+    //状态集合驻留:有序的uint32_t数组首尾相接存放在一块连续内存中,用开放寻址哈希表去重
+    //相比hashMap<hashSet<NFANode *>, int>,每个集合只存一份,且比较时只需一次memcmp
+    class StateSetArena {
+    private:
+        //所有集合的元素
+        std::vector<uint32_t> data;
+        //集合i的元素为data[offsets[i], offsets[i + 1])
+        std::vector<uint32_t> offsets{0};
+        //每个集合的哈希值
+        std::vector<uint64_t> hashes;
+        //哈希表,存放集合编号,-1表示空槽
+        std::vector<int32_t> slots;
+
+        //哈希表扩容为原来的两倍
+        void grow();
+
+    public:
+        //集合的哈希值
+        static uint64_t hashOf(const uint32_t *states, size_t count);
+
+        //返回集合states的编号,inserted表示是否为新集合
+        int intern(const std::vector<uint32_t> &states, bool &inserted);
+
+        //已驻留的集合个数
+        inline int size() const {
+            return (int) hashes.size();
+        }
+
+        //占用的字节数
+        inline size_t memoryUsage() const {
+            return data.capacity() * sizeof(uint32_t) + offsets.capacity() * sizeof(uint32_t) +
+                   hashes.capacity() * sizeof(uint64_t) + slots.capacity() * sizeof(int32_t);
+        }
+
+        //将集合id复制到states,intern可能使data扩容,因此不返回指针
+        inline void get(int id, std::vector<uint32_t> &states) const {
+            states.assign(data.begin() + offsets[id], data.begin() + offsets[id + 1]);
+        }
+    };
+    //一个状态集合经过各字节类到达的集合,按类升序
+    using SubsetSuccessors = std::vector<std::pair<int, std::vector<uint32_t>>>;
+
+    //逐层(BFS)子集构造,结果写入table与statusMap,返回starts中各集合的编号
+    //同一层的状态集合由threads个线程并行求后继,再按层内顺序、类顺序依次驻留,
+    //因此状态编号与单线程时完全相同,不随线程数变化
+    //expand(worker, states, successors, acceptClasses)求states的后继,只能使用worker自己的临时空间;
+    //acceptClasses为下一个字节属于这些类时states可作为终态的类(含断言时才需要),写入acceptBefore
+    //budget不为空时,每驻留一个新状态检查状态数与估计字节数(状态集合 + 按类展开的转换表),每层检查一次耗时
+    template <typename Expand, typename IsFinal>
+    std::vector<int> buildSubsets(const ByteClasses &classes, const std::vector<std::vector<uint32_t>> &starts,
+                                  unsigned threads, Expand &&expand, IsFinal &&isFinal,
+                                  std::vector<hashMap<char, int>> &table, std::vector<bool> &statusMap,
+                                  std::vector<ByteBitmap> *acceptBefore = nullptr,
+                                  const CompileBudget *budget = nullptr) {
+        //每层状态较少时单线程处理
+        constexpr size_t grain = 16;
+        //工作线程在整个子集构造期间复用
+        WorkerPool pool(threads);
+        StateSetArena sets;
+        bool inserted;
+        std::vector<int> startIds;
+        for (const std::vector<uint32_t> &start : starts) {
+            startIds.push_back(sets.intern(start, inserted));
+            if (inserted)
+                statusMap.emplace_back(isFinal(start));
+        }
+        std::vector<SubsetSuccessors> successors;
+        std::vector<std::vector<int>> acceptClasses;
+        //每个后继集合的编号
+        std::vector<std::vector<int>> successorIds;
+        auto checkBudget = [&]() {
+            if (budget == nullptr)
+                return;
+            budget->checkDFA(statusMap.size(),
+                             sets.memoryUsage() + statusMap.size() * classes.count() * sizeof(int));
+            if (statusMap.size() % 1024 == 0)
+                budget->checkTime();
+        };
+        int levelBegin = 0;
+        while (levelBegin < sets.size()) {
+            if (budget != nullptr)
+                budget->checkTime();
+            int levelEnd = sets.size();
+            size_t levelSize = levelEnd - levelBegin;
+            successors.assign(levelSize, SubsetSuccessors());
+            acceptClasses.assign(levelSize, std::vector<int>());
+            successorIds.assign(levelSize, std::vector<int>());
+            //求后继时sets只读
+            pool.parallelEach(levelSize, grain, [&](unsigned worker, size_t i) {
+                std::vector<uint32_t> states;
+                sets.get(levelBegin + (int) i, states);
+                expand(worker, states, successors[i], acceptClasses[i]);
+            });
+            //串行驻留,保证编号确定
+            for (size_t i = 0; i < levelSize; i++) {
+                for (auto &[cls, nextStates] : successors[i]) {
+                    int id = sets.intern(nextStates, inserted);
+                    if (inserted) {
+                        statusMap.emplace_back(isFinal(nextStates));
+                        checkBudget();
+                    }
+                    successorIds[i].push_back(id);
+                }
+            }
+            table.resize(levelEnd);
+            if (acceptBefore != nullptr)
+                acceptBefore->resize(levelEnd, ByteBitmap{});
+            pool.parallelEach(levelSize, grain, [&](unsigned, size_t i) {
+                hashMap<char, int> &row = table[levelBegin + i];
+                for (size_t k = 0; k < successors[i].size(); k++) {
+                    for (char c : classes.bytesOf(successors[i][k].first)) {
+                        row[c] = successorIds[i][k];
+                    }
+                }
+                if (acceptBefore == nullptr)
+                    return;
+                ByteBitmap &bitmap = (*acceptBefore)[levelBegin + i];
+                for (int cls : acceptClasses[i]) {
+                    for (char c : classes.bytesOf(cls))
+                        bitmap[(uint8_t) c >> 6] |= 1ULL << ((uint8_t) c & 63);
+                }
+            });
+            levelBegin = levelEnd;
+        }
+        //终态可能没有出边
+        table.resize(statusMap.size());
+        if (acceptBefore != nullptr)
+            acceptBefore->resize(statusMap.size(), ByteBitmap{});
+        return startIds;
+    }
+}  // namespace zhRegex
+
+#endif  // !_ZH_SUBSET_BUILDER_H_
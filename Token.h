@@ -40,28 +40,42 @@ namespace zhRegex {
         CharEnd,          //以某char结尾,$
         Dash,             //破折号,-
         SingleChar,       //单个字符
-        EscapeChar        //转义字符
+        EscapeChar,       //转义字符
+        WordBoundary,     //单词边界,\b
+        NotWordBoundary,  //非单词边界,\B
+        TextBegin,        //文本开头,\A
+        TextEnd           //文本结尾,\z
     };
 
-    static std::unordered_map<char, RegExToken> initialRegexToken() {
-        std::unordered_map<char, RegExToken> tokens;
-        tokens['.'] = RegExToken::AnyChar;
-        tokens['^'] = RegExToken::CharBegin;
-        tokens['$'] = RegExToken::CharEnd;
-        tokens['('] = RegExToken::LeftParen;
-        tokens[')'] = RegExToken::RightParen;
-        tokens['['] = RegExToken::LeftCollection;
-        tokens[']'] = RegExToken::RightCollection;
-        tokens['{'] = RegExToken::LeftBrace;
-        tokens['}'] = RegExToken::RightBrace;
-        tokens['-'] = RegExToken::Dash;
-        tokens['+'] = RegExToken::Positive;
-        tokens['*'] = RegExToken::Kleene;
-        tokens['|'] = RegExToken::Or;
-        tokens['?'] = RegExToken::Question;
-        return tokens;
-    }
+    //字符 -> token的查找表,以(unsigned char)下标访问,一次访存即可得到token
+    struct RegexTokenTable {
+        RegExToken tokens[CHAR_MAX - CHAR_MIN + 1];
 
-    static std::unordered_map<char, RegExToken> regexTokens = initialRegexToken();
+        constexpr RegexTokenTable() : tokens() {
+            for (auto &token: tokens) {
+                token = RegExToken::SingleChar;
+            }
+            tokens[(unsigned char) '.'] = RegExToken::AnyChar;
+            tokens[(unsigned char) '^'] = RegExToken::CharBegin;
+            tokens[(unsigned char) '$'] = RegExToken::CharEnd;
+            tokens[(unsigned char) '('] = RegExToken::LeftParen;
+            tokens[(unsigned char) ')'] = RegExToken::RightParen;
+            tokens[(unsigned char) '['] = RegExToken::LeftCollection;
+            tokens[(unsigned char) ']'] = RegExToken::RightCollection;
+            tokens[(unsigned char) '{'] = RegExToken::LeftBrace;
+            tokens[(unsigned char) '}'] = RegExToken::RightBrace;
+            tokens[(unsigned char) '-'] = RegExToken::Dash;
+            tokens[(unsigned char) '+'] = RegExToken::Positive;
+            tokens[(unsigned char) '*'] = RegExToken::Kleene;
+            tokens[(unsigned char) '|'] = RegExToken::Or;
+            tokens[(unsigned char) '?'] = RegExToken::Question;
+        }
+
+        constexpr RegExToken operator[](char c) const {
+            return tokens[(unsigned char) c];
+        }
+    };
+
+    inline constexpr RegexTokenTable regexTokens{};
 }  // namespace zhRegex
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
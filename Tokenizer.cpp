@@ -0,0 +1,113 @@
+#include "Tokenizer.h"
+
+#include <ostream>
+
+#include "SubsetBuilder.h"
+
+namespace zhRegex {
+    //每条规则编译为最小DFA后,以(规则,状态)为元素做子集构造:每条规则至多贡献一个状态,
+    //全局编号为offsets[规则] + 状态,集合按规则顺序天然有序;规则的死状态直接去掉
+    Tokenizer::Tokenizer(const std::vector<std::string> &rules, unsigned flags, unsigned threads,
+                         const CompileLimits &limits) : ruleCount(rules.size()) {
+        std::vector<DFA> machines;
+        machines.reserve(rules.size());
+        for (const std::string &rule : rules) {
+            std::string_view pattern = rule;
+            machines.emplace_back(pattern, true, NFAConstruction::thompson, threads, flags, limits);
+            if (!machines.back().lookAccept.empty())
+                throw RegexException(RegexErrorCode::unsupported);
+        }
+        //全局编号 -> 规则
+        std::vector<uint32_t> offsets;
+        std::vector<int> ruleOf;
+        ByteClasses classes;
+        std::vector<uint32_t> keys(256);
+        for (size_t r = 0; r < machines.size(); r++) {
+            offsets.push_back((uint32_t) ruleOf.size());
+            ruleOf.resize(ruleOf.size() + machines[r].stateCount(), (int) r);
+            for (int b = 0; b < 256; b++)
+                keys[b] = (uint32_t) machines[r].transitions.byteClass((char) b);
+            classes.refine(keys);
+        }
+        std::vector<uint32_t> start;
+        for (size_t r = 0; r < machines.size(); r++) {
+            if (machines[r].accel[machines[r].startNode].kind != DFAAccel::Kind::dead)
+                start.push_back(offsets[r] + (uint32_t) machines[r].startNode);
+        }
+        auto expand = [&](unsigned, const std::vector<uint32_t> &states, SubsetSuccessors &successors,
+                          std::vector<int> &) {
+            for (int cls = 0; cls < classes.count(); cls++) {
+                char c = classes.bytesOf(cls)[0];
+                std::vector<uint32_t> nextStates;
+                for (uint32_t state : states) {
+                    const DFA &machine = machines[ruleOf[state]];
+                    int next = machine.transitions.next((int) (state - offsets[ruleOf[state]]), c);
+                    if (next >= 0 && machine.accel[next].kind != DFAAccel::Kind::dead)
+                        nextStates.push_back(offsets[ruleOf[state]] + (uint32_t) next);
+                }
+                if (!nextStates.empty())
+                    successors.emplace_back(cls, std::move(nextStates));
+            }
+        };
+        //isFinal只对新集合按编号顺序调用一次,借此记录每个状态接受的规则
+        std::vector<int> tags;
+        auto isFinal = [&](const std::vector<uint32_t> &states) {
+            int rule = -1;
+            for (uint32_t state : states) {
+                if (machines[ruleOf[state]].statusMap[state - offsets[ruleOf[state]]]) {
+                    rule = ruleOf[state];
+                    break;
+                }
+            }
+            tags.push_back(rule);
+            return rule >= 0;
+        };
+        CompileBudget budget(limits);
+        DFA product;
+        std::vector<int> startIds = buildSubsets(classes, {start}, threads, expand, isFinal, product.table,
+                                                 product.statusMap, nullptr, &budget);
+        product.startNode = startIds[0];
+        for (int &root : product.startStates)
+            root = startIds[0];
+        product.getMinimizeDFA(&budget, &tags);
+        transitions = TransitionTable(product.table);
+        acceptRule = std::move(tags);
+        startNode = product.startNode;
+    }
+
+    //全部token
+    std::vector<TokenSpan> Tokenizer::tokenize(std::string_view input) const {
+        std::vector<TokenSpan> tokens;
+        forEachToken(input, [&](const TokenSpan &token) { tokens.push_back(token); });
+        return tokens;
+    }
+
+    //状态数不超过32767时转移用short存放
+    void Tokenizer::writeTable(std::ostream &out, const std::string &name) const {
+        int states = stateCount();
+        int classCount = transitions.classes();
+        const char *cell = states <= 32767 ? "short" : "int";
+        out << "// " << states << " states, " << classCount << " byte classes, " << ruleCount << " rules\n";
+        out << "static const unsigned char " << name << "_classes[256] = {";
+        for (int b = 0; b < 256; b++)
+            out << (b % 32 == 0 ? "\n    " : " ") << transitions.byteClass((char) b) << ',';
+        out << "\n};\n";
+        out << "static const " << cell << ' ' << name << "_next[" << (size_t) states * classCount << "] = {";
+        for (int status = 0; status < states; status++) {
+            out << "\n   ";
+            for (int cls = 0; cls < classCount; cls++)
+                out << ' ' << transitions.nextByClass(status, cls) << ',';
+        }
+        out << "\n};\n";
+        out << "static const int " << name << "_accept[" << states << "] = {";
+        for (int status = 0; status < states; status++)
+            out << (status % 16 == 0 ? "\n    " : " ") << acceptRule[status] << ',';
+        out << "\n};\n";
+        out << "static const int " << name << "_start = " << startNode << ";\n";
+    }
+
+    //占用的内存字节数
+    size_t Tokenizer::memoryUsage() const {
+        return sizeof(Tokenizer) + transitions.memoryUsage() + acceptRule.capacity() * sizeof(int);
+    }
+}  // namespace zhRegex
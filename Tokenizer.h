@@ -0,0 +1,121 @@
+#ifndef _ZH_TOKENIZER_H_
+#define _ZH_TOKENIZER_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "DFA.h"
+
+namespace zhRegex {
+    //一个token,text指向输入,不复制
+    struct TokenSpan {
+        //规则编号,Tokenizer::errorRule表示没有规则能匹配的单个字节
+        int rule;
+        //在输入中的偏移
+        size_t offset;
+        std::string_view text;
+    };
+
+    //词法分析(多规则tokenizer):把有序的规则编译为一个DFA,一遍扫描输出最长匹配(maximal munch)的token流
+    //每条规则先编译为最小DFA,再对各规则的状态做乘积构造并最小化,终态记录能接受的编号最小(优先级最高)的规则;
+    //规则不能含零宽断言,匹配空串的规则不会产生token
+    //最长匹配在越过最后一个终态后失败时需要回到该终态处重新开始,为避免同一段输入被反复扫描(如规则a与a*b遇到aaa...a),
+    //失败时记下越过部分的(状态,位置),之后再到达这些(状态,位置)时直接停止,每个(状态,位置)至多扫描一次
+    class Tokenizer {
+    private:
+        //合并后的转换表
+        TransitionTable transitions;
+        //每个状态接受的规则编号,-1表示不是终态
+        std::vector<int> acceptRule;
+        int startNode = 0;
+        size_t ruleCount = 0;
+
+    public:
+        static constexpr int errorRule = -1;
+
+        //规则按优先级从高到低排列,非法或含零宽断言时抛出RegexException
+        explicit Tokenizer(const std::vector<std::string> &rules, unsigned flags = RegexFlags::none,
+                           unsigned threads = 1, const CompileLimits &limits = CompileLimits());
+
+        //依次对每个token调用emit(const TokenSpan &),返回token个数
+        template <typename Emit>
+        size_t forEachToken(std::string_view input, Emit &&emit) const;
+
+        //全部token
+        std::vector<TokenSpan> tokenize(std::string_view input) const;
+
+        //以C数组的形式输出状态转换表,供不依赖本库的程序直接嵌入:
+        //  name_classes[256]:字节 -> 等价类
+        //  name_next[状态数 * 类数]:转移,-1表示不存在
+        //  name_accept[状态数]:接受的规则编号,-1表示不是终态
+        //  name_start:起始状态
+        void writeTable(std::ostream &out, const std::string &name) const;
+
+        inline int stateCount() const {
+            return transitions.size();
+        }
+
+        inline size_t rules() const {
+            return ruleCount;
+        }
+
+        //占用的内存字节数
+        size_t memoryUsage() const;
+    };
+
+    template <typename Emit>
+    size_t Tokenizer::forEachToken(std::string_view input, Emit &&emit) const {
+        size_t len = input.size();
+        size_t count = 0;
+        //失败过的(状态,位置),第一次失败时才分配
+        std::vector<bool> failedAt;
+        hashSet<uint64_t> failed;
+        auto key = [&](int status, size_t position) {
+            return (uint64_t) position * (uint64_t) stateCount() + (uint64_t) status;
+        };
+        size_t pos = 0;
+        while (pos < len) {
+            int status = startNode;
+            int rule = errorRule;
+            //最后一个终态的位置与状态
+            size_t end = pos;
+            int endStatus = startNode;
+            size_t i = pos;
+            for (; i < len; i++) {
+                if (!failedAt.empty() && failedAt[i] && failed.count(key(status, i)) != 0)
+                    break;
+                int next = transitions.next(status, input[i]);
+                if (next < 0)
+                    break;
+                status = next;
+                if (acceptRule[status] >= 0) {
+                    rule = acceptRule[status];
+                    end = i + 1;
+                    endStatus = status;
+                }
+            }
+            //从end之后的(状态,位置)出发不可能再到达终态,重放一遍记下来
+            if (i > end) {
+                if (failedAt.empty())
+                    failedAt.assign(len + 1, false);
+                int replay = endStatus;
+                for (size_t j = end; j < i; j++) {
+                    replay = transitions.next(replay, input[j]);
+                    failedAt[j + 1] = true;
+                    failed.insert(key(replay, j + 1));
+                }
+            }
+            if (rule == errorRule)
+                end = pos + 1;
+            emit(TokenSpan{rule, pos, input.substr(pos, end - pos)});
+            count++;
+            pos = end;
+        }
+        return count;
+    }
+}  // namespace zhRegex
+
+#endif  // !_ZH_TOKENIZER_H_
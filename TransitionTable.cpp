@@ -0,0 +1,94 @@
+#include "TransitionTable.h"
+
+#include <type_traits>
+
+namespace zhRegex {
+    //由每个状态的转移(hashMap形式)构造
+    TransitionTable::TransitionTable(const std::vector<hashMap<char, int>> &rows) {
+        constexpr int byteCount = CHAR_MAX - CHAR_MIN + 1;
+        stateCount = (int) rows.size();
+        //逐个状态细化字节等价类:两个字节在所有状态上转移都相同才属于同一类
+        int classOf[byteCount] = {0};
+        classCount = 1;
+        //(旧类,目标状态)的开放寻址表,以stamp区分不同的行,避免每行重新分配hashMap
+        constexpr int slotCount = byteCount * 2;
+        long long slotKey[slotCount];
+        int slotClass[slotCount];
+        int slotStamp[slotCount] = {0};
+        int stamp = 0;
+        for (auto &row: rows) {
+            if (row.empty())
+                continue;
+            long long target[byteCount];
+            for (int b = 0; b < byteCount; b++)
+                target[b] = -1;
+            for (auto &[c, next]: row)
+                target[(uint8_t) c] = next;
+            stamp++;
+            int newClassCount = 0;
+            int newClassOf[byteCount];
+            for (int b = 0; b < byteCount; b++) {
+                long long key = ((long long) classOf[b] << 32) | (target[b] & 0xFFFFFFFFLL);
+                int slot = (int) (((unsigned long long) key * 0x9e3779b97f4a7c15ULL) >> 55);
+                while (slotStamp[slot] == stamp && slotKey[slot] != key)
+                    slot = (slot + 1) % slotCount;
+                if (slotStamp[slot] != stamp) {
+                    slotStamp[slot] = stamp;
+                    slotKey[slot] = key;
+                    slotClass[slot] = newClassCount++;
+                }
+                newClassOf[b] = slotClass[slot];
+            }
+            classCount = newClassCount;
+            for (int b = 0; b < byteCount; b++) {
+                classOf[b] = newClassOf[b];
+            }
+        }
+        for (int b = 0; b < byteCount; b++) {
+            classMap[b] = (uint8_t) classOf[b];
+        }
+        //状态编号需要留出0表示不存在转移
+        narrow = stateCount < UINT16_MAX;
+        size_t cellCount = (size_t) stateCount * classCount;
+        if (narrow)
+            cells16.assign(cellCount, 0);
+        else
+            cells32.assign(cellCount, 0);
+        //同一类中的字节转移相同,直接按行中的字节写入
+        for (int status = 0; status < stateCount; status++) {
+            for (auto &[c, next]: rows[status]) {
+                size_t index = (size_t) status * classCount + classMap[(uint8_t) c];
+                if (narrow)
+                    cells16[index] = (uint16_t) (next + 1);
+                else
+                    cells32[index] = (uint32_t) (next + 1);
+            }
+        }
+    }
+
+    //重新编号,按新的顺序复制各行并改写其中的目标状态
+    void TransitionTable::relabel(const std::vector<int> &order, const std::vector<int> &newId) {
+        auto permute = [&](auto &cells) {
+            std::remove_reference_t<decltype(cells)> result(cells.size());
+            for (int status = 0; status < stateCount; status++) {
+                size_t from = (size_t) order[status] * classCount;
+                size_t to = (size_t) status * classCount;
+                for (int cls = 0; cls < classCount; cls++) {
+                    auto cell = cells[from + cls];
+                    result[to + cls] = cell == 0 ? 0 : (decltype(cell)) (newId[cell - 1] + 1);
+                }
+            }
+            cells.swap(result);
+        };
+        if (narrow)
+            permute(cells16);
+        else
+            permute(cells32);
+    }
+
+    //转换表占用的字节数
+    size_t TransitionTable::memoryUsage() const {
+        return sizeof(TransitionTable) + cells16.capacity() * sizeof(uint16_t) +
+               cells32.capacity() * sizeof(uint32_t);
+    }
+}  // namespace zhRegex
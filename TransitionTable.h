@@ -0,0 +1,71 @@
+#ifndef _ZH_TRANSITION_TABLE_H_
+#define _ZH_TRANSITION_TABLE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "Token.h"
+
+namespace zhRegex {
+    //紧凑的DFA状态转换表
+    //先将256个字节划分为等价类(在所有状态上转移都相同的字节为一类),
+    //再以state * classCount + class为下标存储转移,状态数小于65535时使用16位编号
+    class TransitionTable {
+    private:
+        //字节 -> 等价类
+        uint8_t classMap[CHAR_MAX - CHAR_MIN + 1]{};
+        //等价类个数
+        int classCount{0};
+        //状态个数
+        int stateCount{0};
+        //是否使用16位状态编号
+        bool narrow{true};
+        //存储的是next + 1,0表示不存在转移
+        std::vector<uint16_t> cells16;
+        std::vector<uint32_t> cells32;
+
+    public:
+        TransitionTable() = default;
+
+        //由每个状态的转移(hashMap形式)构造
+        explicit TransitionTable(const std::vector<hashMap<char, int>> &rows);
+
+        //status经过c转移到的状态,不存在则返回-1
+        inline int next(int status, char c) const {
+            size_t index = (size_t) status * classCount + classMap[(uint8_t) c];
+            return narrow ? (int) cells16[index] - 1 : (int) cells32[index] - 1;
+        }
+
+        //status是否存在c边
+        inline bool hasNext(int status, char c) const {
+            return next(status, c) >= 0;
+        }
+
+        //字节c所在的等价类
+        inline int byteClass(char c) const {
+            return classMap[(uint8_t) c];
+        }
+
+        //status经过等价类cls转移到的状态,不存在则返回-1
+        inline int nextByClass(int status, int cls) const {
+            size_t index = (size_t) status * classCount + cls;
+            return narrow ? (int) cells16[index] - 1 : (int) cells32[index] - 1;
+        }
+
+        inline int size() const {
+            return stateCount;
+        }
+
+        inline int classes() const {
+            return classCount;
+        }
+
+        //重新编号:新状态i为旧状态order[i],newId为其逆映射
+        void relabel(const std::vector<int> &order, const std::vector<int> &newId);
+
+        //转换表占用的字节数
+        size_t memoryUsage() const;
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_TRANSITION_TABLE_H_
@@ -0,0 +1,150 @@
+#include "Utf8.h"
+
+#include <algorithm>
+
+namespace zhRegex {
+    //由首字节得到编码长度
+    int Utf8::sequenceLength(uint8_t lead) {
+        if (lead < 0x80)
+            return 1;
+        if (lead < 0xC2)
+            return 0;
+        if (lead < 0xE0)
+            return 2;
+        if (lead < 0xF0)
+            return 3;
+        if (lead < 0xF5)
+            return 4;
+        return 0;
+    }
+
+    //将码点编码为UTF-8
+    int Utf8::encode(uint32_t codePoint, uint8_t bytes[4]) {
+        if (codePoint < 0x80) {
+            bytes[0] = (uint8_t) codePoint;
+            return 1;
+        }
+        if (codePoint < 0x800) {
+            bytes[0] = (uint8_t) (0xC0 | (codePoint >> 6));
+            bytes[1] = (uint8_t) (0x80 | (codePoint & 0x3F));
+            return 2;
+        }
+        if (codePoint < 0x10000) {
+            bytes[0] = (uint8_t) (0xE0 | (codePoint >> 12));
+            bytes[1] = (uint8_t) (0x80 | ((codePoint >> 6) & 0x3F));
+            bytes[2] = (uint8_t) (0x80 | (codePoint & 0x3F));
+            return 3;
+        }
+        bytes[0] = (uint8_t) (0xF0 | (codePoint >> 18));
+        bytes[1] = (uint8_t) (0x80 | ((codePoint >> 12) & 0x3F));
+        bytes[2] = (uint8_t) (0x80 | ((codePoint >> 6) & 0x3F));
+        bytes[3] = (uint8_t) (0x80 | (codePoint & 0x3F));
+        return 4;
+    }
+
+    //解码一个完整的UTF-8序列
+    int32_t Utf8::decode(const uint8_t *bytes, int length) {
+        if (length <= 0 || sequenceLength(bytes[0]) != length)
+            return -1;
+        if (length == 1)
+            return bytes[0];
+        uint32_t codePoint = bytes[0] & (0x7F >> length);
+        for (int i = 1; i < length; i++) {
+            if ((bytes[i] & 0xC0) != 0x80)
+                return -1;
+            codePoint = (codePoint << 6) | (bytes[i] & 0x3F);
+        }
+        //过长编码
+        static constexpr uint32_t minCodePoint[5] = {0, 0, 0x80, 0x800, 0x10000};
+        if (codePoint < minCodePoint[length] || codePoint > maxCodePoint
+            || (surrogateBegin <= codePoint && codePoint <= surrogateEnd))
+            return -1;
+        return (int32_t) codePoint;
+    }
+
+    //排序并合并区间
+    void Utf8::normalize(std::vector<CodePointRange> &ranges) {
+        std::sort(ranges.begin(), ranges.end());
+        size_t count = 0;
+        for (const CodePointRange &range : ranges) {
+            if (count > 0 && range.first <= ranges[count - 1].second + 1)
+                ranges[count - 1].second = std::max(ranges[count - 1].second, range.second);
+            else
+                ranges[count++] = range;
+        }
+        ranges.resize(count);
+    }
+
+    //对全部合法码点取反
+    void Utf8::negate(std::vector<CodePointRange> &ranges) {
+        std::vector<CodePointRange> inverse;
+        uint32_t next = 0;
+        for (const CodePointRange &range : ranges) {
+            if (range.first > next)
+                inverse.emplace_back(next, range.first - 1);
+            next = range.second + 1;
+        }
+        if (next <= maxCodePoint)
+            inverse.emplace_back(next, maxCodePoint);
+        ranges.swap(inverse);
+    }
+
+    //将码点区间拆分为字节区间序列
+    //先按编码长度拆分,再拆分到每个后续字节都取满[80,BF]或只有一个值,此时首尾码点逐字节对应即为一个序列
+    void Utf8::split(CodePointRange range, std::vector<Utf8Sequence> &sequences) {
+        //后处理的区间先入栈,保证输出按码点升序
+        std::vector<CodePointRange> rangeStack{range};
+        while (!rangeStack.empty()) {
+            auto [first, last] = rangeStack.back();
+            rangeStack.pop_back();
+            last = std::min(last, maxCodePoint);
+            if (first > last)
+                continue;
+            //跳过代理区
+            if (first <= surrogateEnd && last >= surrogateBegin) {
+                if (last > surrogateEnd)
+                    rangeStack.emplace_back(surrogateEnd + 1, last);
+                if (first < surrogateBegin)
+                    rangeStack.emplace_back(first, surrogateBegin - 1);
+                continue;
+            }
+            //按编码长度拆分
+            bool splitted = false;
+            for (uint32_t boundary : {0x7Fu, 0x7FFu, 0xFFFFu}) {
+                if (first <= boundary && boundary < last) {
+                    rangeStack.emplace_back(boundary + 1, last);
+                    rangeStack.emplace_back(first, boundary);
+                    splitted = true;
+                    break;
+                }
+            }
+            if (splitted)
+                continue;
+            //从最低的后续字节开始,拆分到其余字节可以独立取区间
+            for (int i = 1; i < 4 && !splitted; i++) {
+                uint32_t mask = (1u << (6 * i)) - 1;
+                if ((first & ~mask) == (last & ~mask))
+                    continue;
+                if ((first & mask) != 0) {
+                    rangeStack.emplace_back((first | mask) + 1, last);
+                    rangeStack.emplace_back(first, first | mask);
+                    splitted = true;
+                } else if ((last & mask) != mask) {
+                    rangeStack.emplace_back(last & ~mask, last);
+                    rangeStack.emplace_back(first, (last & ~mask) - 1);
+                    splitted = true;
+                }
+            }
+            if (splitted)
+                continue;
+            uint8_t firstBytes[4], lastBytes[4];
+            int length = encode(first, firstBytes);
+            encode(last, lastBytes);
+            Utf8Sequence sequence(length);
+            for (int i = 0; i < length; i++) {
+                sequence[i] = {firstBytes[i], lastBytes[i]};
+            }
+            sequences.emplace_back(std::move(sequence));
+        }
+    }
+}  // namespace zhRegex
@@ -0,0 +1,48 @@
+#ifndef _ZH_UTF8_H_
+#define _ZH_UTF8_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace zhRegex {
+    // Unicode码点区间[first, second]
+    using CodePointRange = std::pair<uint32_t, uint32_t>;
+
+    //一个字节区间[lo, hi]
+    struct Utf8ByteRange {
+        uint8_t lo;
+        uint8_t hi;
+
+        inline bool operator==(const Utf8ByteRange &other) const {
+            return lo == other.lo && hi == other.hi;
+        }
+    };
+
+    //依次匹配每个字节区间的序列,一个码点区间可拆分为若干个这样的序列
+    using Utf8Sequence = std::vector<Utf8ByteRange>;
+
+    //UTF-8编码相关的工具函数
+    class Utf8 {
+    public:
+        static constexpr uint32_t maxCodePoint = 0x10FFFF;
+        static constexpr uint32_t surrogateBegin = 0xD800;
+        static constexpr uint32_t surrogateEnd = 0xDFFF;
+
+        //由首字节得到编码长度,非法首字节返回0
+        static int sequenceLength(uint8_t lead);
+        //将码点编码为UTF-8,返回字节数
+        static int encode(uint32_t codePoint, uint8_t bytes[4]);
+        //解码bytes[0, length),非法编码(过长编码、代理区、超出范围)返回-1
+        static int32_t decode(const uint8_t *bytes, int length);
+
+        //排序并合并相交或相邻的区间
+        static void normalize(std::vector<CodePointRange> &ranges);
+        //对全部合法码点(不含代理区)取反,ranges须已normalize
+        static void negate(std::vector<CodePointRange> &ranges);
+        //将码点区间拆分为字节区间序列,按码点升序追加到sequences,代理区会被跳过
+        static void split(CodePointRange range, std::vector<Utf8Sequence> &sequences);
+    };
+}  // namespace zhRegex
+
+#endif  // !_ZH_UTF8_H_
@@ -1,11 +1,294 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <random>
+#include <thread>
 
+#include "DiffFuzz.h"
+#include "DirectoryScanner.h"
+#include "LineSearcher.h"
 #include "Regex.h"
+#include "ScanPipeline.h"
+#include "Tokenizer.h"
 
 using namespace std;
 using namespace zhRegex;
 
+//测量function的耗时(秒)
+template <typename Function>
+static double timeIt(Function &&function) {
+    auto begin = chrono::steady_clock::now();
+    function();
+    return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+//交错执行的吞吐量测试:批量短输入时lanes个输入同步推进,长输入时切分为chunks块同步推进
+static int benchmarkLanes() {
+    string_view pattern = "[+-]?[0-9]+(\\.[0-9]+)?(e[+-]?[0-9]+)?f?";
+    DFA machine(pattern);
+    Regex regex(&machine);
+    mt19937 rng(20240601);
+    const char alphabet[] = "0123456789.e+-";
+    //大量短输入
+    vector<string> storage(1 << 20);
+    size_t totalBytes = 0;
+    for (auto &s: storage) {
+        int len = 4 + (int) (rng() % 12);
+        for (int i = 0; i < len; i++) s += alphabet[rng() % (sizeof(alphabet) - 1)];
+        totalBytes += s.size();
+    }
+    vector<string_view> inputs(storage.begin(), storage.end());
+    vector<uint8_t> out(inputs.size());
+    cout << "batch: " << inputs.size() << " inputs, " << totalBytes << " bytes\n";
+    for (int lanes: {1, 2, 4, 8, 16}) {
+        double seconds = timeIt([&]() { regex.matchBatch(inputs.data(), inputs.size(), out.data(), 1, lanes); });
+        cout << "  lanes=" << lanes << "\t" << totalBytes / seconds / 1e6 << " MB/s\n";
+    }
+    //单个长输入,选用没有自环的pattern以免被加速态跳过
+    string_view pairPattern = "([a-z][0-9])*";
+    DFA pairMachine(pairPattern);
+    Regex pairRegex(&pairMachine);
+    string longInput;
+    longInput.reserve(64 << 20);
+    while (longInput.size() < (64 << 20)) {
+        longInput += (char) ('a' + rng() % 26);
+        longInput += (char) ('0' + rng() % 10);
+    }
+    string_view longView = longInput;
+    cout << "chunked: " << longInput.size() << " bytes\n";
+    for (int chunks: {1, 2, 4, 8, 16}) {
+        bool matched = false;
+        double seconds = timeIt([&]() { matched = pairRegex.matchChunked(longView, chunks); });
+        cout << "  chunks=" << chunks << "\t" << longInput.size() / seconds / 1e6 << " MB/s\t" << matched << "\n";
+    }
+    return 0;
+}
+
+//打印各趟AST化简后的AST节点、NFA节点与DFA状态个数
+static int reportPasses(string_view pattern) {
+    Parser parser(pattern);
+    RegexAST ast = parser.parse();
+    auto measure = [&ast](ASTPassReport &report) {
+        NFA nfa(ast);
+        DFA dfa(nfa);
+        report.nfaNodes = nfa.nodeCount();
+        report.dfaStates = dfa.stateCount();
+    };
+    ASTPassReport original{"original", 0, (int) ASTOptimizer(ast).nodeCount()};
+    measure(original);
+    vector<ASTPassReport> reports = ASTOptimizer::optimize(ast, measure);
+    reports.insert(reports.begin(), original);
+    cout << "pass\tast\tnfa\tdfa\n";
+    for (auto &report: reports) {
+        cout << report.name << "\t" << report.nodesAfter << "\t" << report.nfaNodes << "\t" << report.dfaStates << "\n";
+    }
+    return 0;
+}
+
+//按行查找,用法与grep相近:--grep [-v] [-c] [-n] [-r] [-i] PATTERN [FILE...],没有FILE时读取标准输入
+//-v输出不匹配的行,-i忽略大小写,-c只输出行数,-n输出行号,-r递归查找目录(没有FILE时为当前目录);
+//找到时返回0,否则返回1,出错返回2
+static int grepFiles(int argc, char *argv[]) {
+    bool invert = false, countOnly = false, lineNumbers = false, recursive = false;
+    unsigned flags = RegexFlags::none;
+    int i = 0;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        for (const char *flag = argv[i] + 1; *flag != '\0'; flag++) {
+            if (*flag == 'v')
+                invert = true;
+            else if (*flag == 'c')
+                countOnly = true;
+            else if (*flag == 'n')
+                lineNumbers = true;
+            else if (*flag == 'r')
+                recursive = true;
+            else if (*flag == 'i')
+                flags |= RegexFlags::caseInsensitive;
+            else {
+                cerr << "unknown option -" << *flag << "\n";
+                return 2;
+            }
+        }
+    }
+    if (i >= argc) {
+        cerr << "usage: --grep [-v] [-c] [-n] [-r] [-i] PATTERN [FILE...]\n";
+        return 2;
+    }
+    unique_ptr<LineSearcher> searcher;
+    try {
+        searcher = make_unique<LineSearcher>(argv[i++], flags);
+    } catch (const RegexException &e) {
+        cerr << e.what() << "\n";
+        return 2;
+    }
+    vector<string> files(argv + i, argv + argc);
+    bool showFile = files.size() > 1 || recursive;
+    if (files.empty())
+        files.emplace_back(recursive ? "." : "-");
+    if (recursive)
+        files = DirectoryScanner::listFiles(files);
+    vector<string> paths = files;
+    for (string &path: paths) {
+        if (path == "-")
+            path = "/dev/stdin";
+    }
+    string out;
+    bool failed = false;
+    ScanCallbacks callbacks;
+    if (!countOnly) {
+        callbacks.onLine = [&](const ScanLine &line) {
+            if (showFile)
+                out += files[line.file] + ":";
+            if (lineNumbers)
+                out += to_string(line.lineNumber) + ":";
+            out.append(line.text.data(), line.text.size());
+            out += '\n';
+            if (out.size() >= (1 << 16)) {
+                cout << out;
+                out.clear();
+            }
+        };
+    }
+    callbacks.onFileEnd = [&](size_t file, size_t matched) {
+        if (countOnly)
+            out += (showFile ? files[file] + ":" : "") + to_string(matched) + "\n";
+        cout << out;
+        out.clear();
+    };
+    callbacks.onError = [&](size_t file) {
+        cout << out;
+        out.clear();
+        cerr << files[file] << ": cannot open\n";
+        failed = true;
+    };
+    //目录树由DirectoryScanner并行扫描,否则由ScanPipeline流水线读取与匹配,回调都按文件顺序依次调用
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    size_t total;
+    if (recursive) {
+        DirectoryScanOptions options;
+        options.threads = threads;
+        options.invert = invert;
+        total = DirectoryScanner(*searcher, options).scan(paths, callbacks);
+    } else {
+        ScanOptions options;
+        options.readers = min(threads, 4u);
+        options.matchers = threads;
+        options.invert = invert;
+        total = ScanPipeline(*searcher, options).scan(paths, callbacks);
+    }
+    if (failed)
+        return 2;
+    return total > 0 ? 0 : 1;
+}
+
+//转义输出中的控制字符,便于复制失败的用例
+static string printable(const string &text) {
+    string out;
+    for (char c: text) {
+        if (c == '\n')
+            out += "\\n";
+        else if (c == '\\')
+            out += "\\\\";
+        else
+            out += c;
+    }
+    return out;
+}
+
+//多引擎差分测试:--fuzz [ITERATIONS] [SEED],发现不一致时返回1
+static int fuzzEngines(int argc, char *argv[]) {
+    FuzzOptions options;
+    if (argc > 0)
+        options.iterations = stoul(argv[0]);
+    if (argc > 1)
+        options.seed = stoull(argv[1]);
+    //随机pattern中不应出现状态爆炸,超出限制的pattern作为性能异常报告
+    options.limits.maxDFAStates = 100000;
+    options.limits.maxTime = chrono::milliseconds(5000);
+    FuzzReport report = DiffFuzzer(options).run();
+    cout << "patterns " << report.patterns << ", rejected " << report.rejected << ", inputs " << report.inputs
+         << ", compile " << report.compileSeconds << "s, max states " << report.maxStates << ", "
+         << options.chainLength << "-byte literal " << report.chainSeconds << "s\n";
+    for (const FuzzPathology &slow: report.pathologies) {
+        cout << "SLOW flags=" << slow.flags << " pattern=" << printable(slow.pattern) << " " << slow.seconds << "s "
+             << slow.states << " states " << slow.limit << "\n";
+    }
+    for (const FuzzFailure &failure: report.failures) {
+        cout << "FAIL " << failure.detail << " flags=" << failure.flags << " pattern=" << printable(failure.pattern)
+             << " input=" << printable(failure.input) << "\n";
+    }
+    return report.failures.empty() ? 0 : 1;
+}
+
+//多规则词法分析:--tokenize RULES [FILE]输出每个token的规则编号、偏移与内容,
+//--tokenize --table NAME RULES输出可嵌入的C数组;RULES每行一条规则,越靠前优先级越高
+static int tokenizeFile(int argc, char *argv[]) {
+    string tableName;
+    int i = 0;
+    if (argc > 1 && strcmp(argv[0], "--table") == 0) {
+        tableName = argv[1];
+        i = 2;
+    }
+    if (i >= argc) {
+        cerr << "usage: --tokenize [--table NAME] RULES [FILE]\n";
+        return 2;
+    }
+    ifstream rulesFile(argv[i]);
+    if (!rulesFile) {
+        cerr << "cannot open " << argv[i] << "\n";
+        return 2;
+    }
+    vector<string> rules;
+    for (string line; getline(rulesFile, line);) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        rules.push_back(line);
+    }
+    unique_ptr<Tokenizer> tokenizer;
+    try {
+        tokenizer = make_unique<Tokenizer>(rules, RegexFlags::none, thread::hardware_concurrency());
+    } catch (const RegexException &e) {
+        cerr << e.what() << "\n";
+        return 2;
+    }
+    if (!tableName.empty()) {
+        tokenizer->writeTable(cout, tableName);
+        return 0;
+    }
+    ifstream inputFile;
+    if (i + 1 < argc) {
+        inputFile.open(argv[i + 1], ios::binary);
+        if (!inputFile) {
+            cerr << "cannot open " << argv[i + 1] << "\n";
+            return 2;
+        }
+    }
+    istream &in = i + 1 < argc ? inputFile : cin;
+    string input((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    tokenizer->forEachToken(input, [](const TokenSpan &token) {
+        cout << token.rule << '\t' << token.offset << '\t' << printable(string(token.text)) << '\n';
+    });
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--grep") == 0) {
+        return grepFiles(argc - 2, argv + 2);
+    }
+    if (argc > 2 && strcmp(argv[1], "--ast-report") == 0) {
+        return reportPasses(argv[2]);
+    }
+    if (argc > 1 && strcmp(argv[1], "--fuzz") == 0) {
+        return fuzzEngines(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--tokenize") == 0) {
+        return tokenizeFile(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-lanes") == 0) {
+        return benchmarkLanes();
+    }
     cout << "Hello, world!" << endl;
     // string input = "THISISREGEXTEST";
     // string pattern = "([A-Z]*|[0-9]+)";
@@ -22,4 +305,4 @@ int main(int argc, char *argv[]) {
     }
     delete machine;
     return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file